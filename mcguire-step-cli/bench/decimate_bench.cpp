@@ -0,0 +1,120 @@
+// bench/decimate_bench.cpp
+//
+// Decimates a finely tessellated, slightly noisy torus and reports
+// throughput with one thread and with every hardware thread, together with
+// how far the result strays from the analytic surface.
+//
+// Usage: decimate_bench [segments=2000] [ratio=0.1] [threads=hardware]
+// The torus has 2 * segments * segments / 2 triangles.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "mesh.h"
+#include "mesh_decimate.h"
+
+namespace {
+
+constexpr double kMajorRadius = 1.0;
+constexpr double kMinorRadius = 0.3;
+constexpr double kNoise = 1e-4;
+constexpr double kPi = 3.14159265358979323846;
+
+mcguire::Mesh makeTorus(int segments) {
+    const int rings = segments / 2;
+    mcguire::Mesh mesh;
+    mesh.name = "torus";
+    mesh.reserve(size_t(segments) * rings, size_t(segments) * rings * 2);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> noise(-kNoise, kNoise);
+    for (int i = 0; i < segments; ++i) {
+        double u = 2 * kPi * i / segments;
+        for (int j = 0; j < rings; ++j) {
+            double v = 2 * kPi * j / rings;
+            double r = kMinorRadius + noise(rng);
+            mesh.addVertex((kMajorRadius + r * std::cos(v)) * std::cos(u),
+                           (kMajorRadius + r * std::cos(v)) * std::sin(u),
+                           r * std::sin(v));
+        }
+    }
+    for (int i = 0; i < segments; ++i) {
+        for (int j = 0; j < rings; ++j) {
+            uint32_t a = uint32_t(i * rings + j);
+            uint32_t b = uint32_t(((i + 1) % segments) * rings + j);
+            uint32_t c = uint32_t(((i + 1) % segments) * rings + (j + 1) % rings);
+            uint32_t d = uint32_t(i * rings + (j + 1) % rings);
+            mesh.addTriangle(a, b, c);
+            mesh.addTriangle(a, c, d);
+        }
+    }
+    return mesh;
+}
+
+// Distance of a point from the ideal torus surface.
+double surfaceDistance(double x, double y, double z) {
+    double ring = std::sqrt(x * x + y * y) - kMajorRadius;
+    return std::abs(std::sqrt(ring * ring + z * z) - kMinorRadius);
+}
+
+// Faces using the same three vertices as another face; must stay zero.
+size_t duplicateFaces(const mcguire::Mesh& mesh) {
+    std::vector<std::array<uint32_t, 3>> faces(mesh.triangleCount());
+    for (size_t t = 0; t < faces.size(); ++t) {
+        faces[t] = {mesh.indices[t * 3], mesh.indices[t * 3 + 1], mesh.indices[t * 3 + 2]};
+        std::sort(faces[t].begin(), faces[t].end());
+    }
+    std::sort(faces.begin(), faces.end());
+    return faces.size() - (std::unique(faces.begin(), faces.end()) - faces.begin());
+}
+
+void run(const mcguire::Mesh& source, double ratio, unsigned threads) {
+    mcguire::Mesh mesh = source;
+    mcguire::DecimateOptions options;
+    options.targetTriangles = static_cast<size_t>(mesh.triangleCount() * ratio);
+    options.threads = threads;
+
+    auto start = std::chrono::steady_clock::now();
+    mcguire::DecimateStats stats = mcguire::decimate(mesh, options);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double maxDistance = 0, sumSquares = 0;
+    for (size_t v = 0; v < mesh.vertexCount(); ++v) {
+        double d = surfaceDistance(mesh.x[v], mesh.y[v], mesh.z[v]);
+        maxDistance = std::max(maxDistance, d);
+        sumSquares += d * d;
+    }
+    double rms = mesh.vertexCount() ? std::sqrt(sumSquares / mesh.vertexCount()) : 0.0;
+
+    std::printf("threads %3u  %10zu -> %9zu tris  %7.3f s  %6.2f Mtri/s  "
+                "quadric rms max %.2e  surface max %.2e rms %.2e  duplicates %zu\n",
+                threads, stats.trianglesBefore, stats.trianglesAfter, seconds,
+                (stats.trianglesBefore - stats.trianglesAfter) / seconds / 1e6,
+                stats.maxError, maxDistance, rms, duplicateFaces(mesh));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int segments = argc > 1 ? std::atoi(argv[1]) : 2000;
+    double ratio = argc > 2 ? std::atof(argv[2]) : 0.1;
+    int threads = argc > 3 ? std::atoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+    if (segments < 8 || !(ratio > 0.0 && ratio <= 1.0) || threads < 0) {
+        std::fprintf(stderr, "Usage: decimate_bench [segments>=8] [ratio (0-1]] [threads]\n");
+        return 1;
+    }
+
+    mcguire::Mesh torus = makeTorus(segments);
+    std::printf("torus: %zu vertices, %zu triangles, target ratio %.3f\n",
+                torus.vertexCount(), torus.triangleCount(), ratio);
+
+    run(torus, ratio, 1);
+    if (threads > 1) run(torus, ratio, static_cast<unsigned>(threads));
+    return 0;
+}
@@ -0,0 +1,17 @@
+// include/json_passthrough.h
+#pragma once
+#include <string>
+
+// Checks that inputPath is a mesh JSON document without building a DOM: a
+// top-level object whose "vertices" array holds [x, y, z] numbers and whose
+// "faces" (triangles or polygons) or "tetrahedra" array holds non-negative
+// indices into it. Once both arrays have been checked, the rest of the
+// document is only checked for syntax, up to the end of the file, so that
+// truncated or trailing-garbage files are still rejected. On failure,
+// reason (when given) explains what was wrong.
+bool isJsonFileValid(const std::string& inputPath, std::string* reason = nullptr);
+
+// Validates inputPath and copies it to outputPath using a kernel-side copy
+// where available. Nothing is copied when both paths name the same file.
+// Throws std::runtime_error on invalid input or I/O failure.
+void passThroughJson(const std::string& inputPath, const std::string& outputPath);
@@ -0,0 +1,99 @@
+// include/mesh.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mcguire {
+
+// Triangle mesh shared by every converter. Positions are stored as a
+// structure of arrays so welding, decimation and serialization can walk
+// one coordinate stream at a time.
+struct Mesh {
+    std::string name;
+    std::vector<double> x, y, z;
+    std::vector<uint32_t> indices; // three per triangle
+
+    size_t vertexCount() const { return x.size(); }
+    size_t triangleCount() const { return indices.size() / 3; }
+    bool isEmpty() const { return x.empty() && indices.empty(); }
+
+    uint32_t addVertex(double px, double py, double pz) {
+        uint32_t id = static_cast<uint32_t>(x.size());
+        x.push_back(px);
+        y.push_back(py);
+        z.push_back(pz);
+        return id;
+    }
+
+    void addTriangle(uint32_t a, uint32_t b, uint32_t c) {
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+
+    void reserve(size_t vertices, size_t triangles);
+
+    // Drops the contents but keeps the allocated buffers.
+    void clear();
+};
+
+// Pool of meshes whose buffers survive reset(), so repeated conversions in
+// one process stop paying for reallocation. References returned by
+// acquire() stay valid until the arena is destroyed.
+class MeshArena {
+public:
+    Mesh& acquire(const std::string& name = std::string());
+
+    // Returns the most recently acquired mesh to the pool.
+    void discardLast();
+
+    void reset();
+
+    size_t size() const { return used_; }
+    bool empty() const { return used_ == 0; }
+    Mesh& operator[](size_t i) { return pool_[i]; }
+    const Mesh& operator[](size_t i) const { return pool_[i]; }
+    Mesh& back() { return pool_[used_ - 1]; }
+
+private:
+    std::deque<Mesh> pool_;
+    size_t used_ = 0;
+};
+
+// Merges coincident vertices while a mesh is being built. A tolerance of
+// zero welds bit-identical positions only (signed zeros compare equal);
+// a positive tolerance merges points that lie within it on every axis.
+class VertexWelder {
+public:
+    explicit VertexWelder(double tolerance = 0.0);
+
+    // Starts welding into mesh. Lookup state from the previous mesh is
+    // dropped but its memory is kept.
+    void begin(Mesh& mesh, size_t expectedVertices = 0);
+
+    uint32_t weld(double px, double py, double pz);
+
+private:
+    struct CellKey {
+        int64_t i, j, k;
+        bool operator==(const CellKey& o) const { return i == o.i && j == o.j && k == o.k; }
+    };
+    struct CellHash {
+        size_t operator()(const CellKey& key) const;
+    };
+
+    CellKey cellOf(double px, double py, double pz) const;
+    bool findInCell(const CellKey& key, double px, double py, double pz, uint32_t& found) const;
+
+    Mesh* mesh_ = nullptr;
+    double tolerance_;
+    double cellSize_;
+    std::unordered_map<CellKey, uint32_t, CellHash> heads_;
+    std::vector<uint32_t> next_;
+};
+
+} // namespace mcguire
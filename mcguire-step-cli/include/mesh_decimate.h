@@ -0,0 +1,44 @@
+// include/mesh_decimate.h
+#pragma once
+#include <cstddef>
+
+#include "mesh.h"
+
+namespace mcguire {
+
+struct DecimateOptions {
+    // Stop once the mesh has at most this many triangles (0: no count target).
+    size_t targetTriangles = 0;
+    // Stop before any collapse whose error exceeds this distance, in model
+    // units (0: no error bound). The error of a vertex is the RMS distance
+    // to the planes of the original faces it has absorbed; individual
+    // points of the surface can deviate by more.
+    double maxError = 0.0;
+    // Keep open boundaries in place. Attribute seams that the welder left
+    // as duplicate vertices show up as boundaries, so they are kept as well.
+    bool preserveBoundary = true;
+    // Worker threads for the clustered pass (0: hardware concurrency).
+    unsigned threads = 0;
+};
+
+struct DecimateStats {
+    size_t trianglesBefore = 0;
+    size_t trianglesAfter = 0;
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    // Largest RMS quadric error of any collapse performed.
+    double maxError = 0.0;
+};
+
+// Simplifies mesh in place by quadric-error edge collapse on its welded
+// index buffer. Large meshes are first split into spatial clusters that are
+// decimated in parallel with their shared border locked; a serial pass over
+// the whole mesh then finishes the job. Non-manifold edges are never
+// collapsed, triangles are never flipped, and collapses that fail the link
+// condition (which would create duplicate faces, e.g. on a tetrahedron) are
+// skipped, so closed parts never shrink below four faces. With boundaries
+// free to move, an interior edge joining two boundary vertices is never
+// collapsed, as that would pinch the surface into a bowtie.
+DecimateStats decimate(Mesh& mesh, const DecimateOptions& options);
+
+} // namespace mcguire
@@ -0,0 +1,72 @@
+// include/mesh_json.h
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "mesh.h"
+
+namespace mcguire {
+
+// Minimal streaming JSON emitter. Output is buffered and written to the
+// stream in large chunks; no document tree is ever built.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream& out);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    void key(std::string_view name);
+    void number(double v);
+    void integer(long long v);
+    void string(std::string_view v);
+    void boolean(bool v);
+    void null();
+
+    // Writes buffered output to the stream and flushes it.
+    void flush();
+
+private:
+    void separator();
+    void open(char c);
+    void close(char c);
+    void spill();
+
+    std::ostream& out_;
+    std::string buf_;
+    std::vector<bool> first_;
+    bool afterKey_ = false;
+};
+
+// Writes "vertices" and "faces" of mesh into the currently open object.
+void writeMeshFields(JsonWriter& w, const Mesh& mesh);
+
+// Writes the meshes into the currently open object using the CLI layout: a
+// single mesh is flattened to top-level "vertices"/"faces" (plus "name"
+// unless it equals defaultName), several meshes go under "meshes" with a
+// "mesh_count".
+void writeMeshCollection(JsonWriter& w, const MeshArena& meshes, const std::string& defaultName);
+
+// Same as above for the meshes in [begin, end) of the arena.
+void writeMeshCollection(JsonWriter& w, const MeshArena& meshes, size_t begin, size_t end,
+                         const std::string& defaultName);
+
+struct MeshDocumentOptions {
+    std::string defaultName;
+    std::vector<std::pair<std::string, double>> metadata;
+};
+
+// Writes a complete mesh document to outputPath.
+void writeMeshDocument(const std::string& outputPath, const MeshArena& meshes,
+                       const MeshDocumentOptions& options);
+
+} // namespace mcguire
@@ -0,0 +1,115 @@
+// include/mesh_sink.h
+#pragma once
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mesh.h"
+#include "mesh_json.h"
+
+namespace mcguire {
+
+using MeshMetadata = std::vector<std::pair<std::string, double>>;
+
+// One level of detail. Meshes committed after beginLevel() belong to it.
+struct MeshLevel {
+    MeshMetadata metadata;
+    size_t meshCount = 0;
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+};
+
+// Destination for converted meshes. Converters fill the mesh returned by
+// acquire() and commit() it as soon as it is complete, so sinks that stream
+// can write it out before the next body is even started.
+class MeshSink {
+public:
+    explicit MeshSink(MeshArena& meshes) : meshes_(meshes) {}
+    virtual ~MeshSink() = default;
+
+    Mesh& acquire(const std::string& name);
+
+    // Hands over the mesh from the last acquire(). Empty meshes are kept
+    // only when keepEmpty is set.
+    void commit(bool keepEmpty = false);
+
+    // Starts a new level of detail; metadata describes it (deflections).
+    // Sinks that never see a level write a flat, single-level output.
+    void beginLevel(MeshMetadata metadata);
+
+    // Runs filter on every non-empty mesh in commit(), before it is counted
+    // and handed to the sink, e.g. to decimate it.
+    void setMeshFilter(std::function<void(Mesh&)> filter) { filter_ = std::move(filter); }
+
+    // Writes whatever follows the last mesh. Call exactly once.
+    virtual void finish(const MeshMetadata& metadata) = 0;
+
+    size_t meshCount() const { return meshCount_; }
+    size_t vertexCount() const { return vertexCount_; }
+    size_t triangleCount() const { return triangleCount_; }
+    const std::vector<MeshLevel>& levels() const { return levels_; }
+
+protected:
+    // Returns true if the sink still needs the mesh after this call.
+    virtual bool onCommit(Mesh& mesh) = 0;
+    virtual void onBeginLevel(const MeshLevel& level) = 0;
+
+    MeshArena& meshes_;
+
+private:
+    size_t meshCount_ = 0;
+    size_t vertexCount_ = 0;
+    size_t triangleCount_ = 0;
+    std::vector<MeshLevel> levels_;
+    std::function<void(Mesh&)> filter_;
+};
+
+// Collects every mesh and writes one JSON document in finish(), in the
+// layout produced by writeMeshDocument(). With levels, each level's meshes
+// are written in that layout to one entry of a "lod" array, together with
+// the level metadata and its vertex and triangle counts.
+class DocumentSink : public MeshSink {
+public:
+    DocumentSink(const std::string& outputPath, MeshArena& meshes, std::string defaultName);
+
+    void finish(const MeshMetadata& metadata) override;
+
+protected:
+    bool onCommit(Mesh& mesh) override;
+    void onBeginLevel(const MeshLevel& level) override;
+
+private:
+    std::string outputPath_;
+    std::string defaultName_;
+    std::vector<size_t> levelStarts_;
+};
+
+// Writes newline-delimited JSON: one self-contained
+// {"type":"mesh","index",...,"name","vertices","faces"} record per mesh as
+// soon as it is committed, then a {"type":"trailer"} record with the counts
+// and metadata. Each level starts with a {"type":"level"} record, mesh
+// records carry their "level" and the trailer lists per-level counts. An
+// output path of "-" writes to stdout.
+class NdjsonSink : public MeshSink {
+public:
+    NdjsonSink(const std::string& outputPath, MeshArena& meshes);
+    ~NdjsonSink() override;
+
+    void finish(const MeshMetadata& metadata) override;
+
+protected:
+    bool onCommit(Mesh& mesh) override;
+    void onBeginLevel(const MeshLevel& level) override;
+
+private:
+    void endRecord();
+
+    std::ofstream file_;
+    std::ostream* out_;
+    std::unique_ptr<JsonWriter> writer_;
+};
+
+} // namespace mcguire
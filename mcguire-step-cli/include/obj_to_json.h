@@ -1,4 +1,15 @@
 #pragma once
 #include <string>
 
+namespace mcguire { class MeshArena; class MeshSink; }
+
 void convertObjToJson(const std::string& inputPath, const std::string& outputPath);
+
+// Same as above, building the meshes in a caller-owned arena so its buffers
+// can be reused across conversions.
+void convertObjToJson(const std::string& inputPath, const std::string& outputPath,
+                      mcguire::MeshArena& meshes);
+
+// Parses inputPath and commits each mesh to sink as soon as it is complete,
+// then finishes the sink.
+void readObj(const std::string& inputPath, mcguire::MeshSink& sink);
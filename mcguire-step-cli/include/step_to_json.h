@@ -1,5 +1,44 @@
 // include/step_to_json.h
 #pragma once
 #include <string>
+#include <vector>
+
+namespace mcguire { class MeshArena; class MeshSink; }
+
+struct StepLodLevel {
+    double linearDeflection;
+    double angularDeflection = 0.5;
+};
+
+struct StepConvertOptions {
+    double deflection = 0.1;
+    // Bodies to mesh, by manifest index or name. Empty meshes every body.
+    std::vector<std::string> bodies;
+    // When set, every body is meshed once per level (coarse to fine) and
+    // deflection is ignored.
+    std::vector<StepLodLevel> lods;
+};
 
 void convertStepToJson(const std::string& inputPath, const std::string& outputPath);
+void convertStepToJson(const std::string& inputPath, const std::string& outputPath, double deflection);
+void convertStepToJson(const std::string& inputPath, const std::string& outputPath,
+                       const StepConvertOptions& options);
+
+// Same as above, building the meshes in a caller-owned arena so its buffers
+// can be reused across conversions.
+void convertStepToJson(const std::string& inputPath, const std::string& outputPath,
+                       mcguire::MeshArena& meshes, const StepConvertOptions& options);
+
+// Meshes the selected bodies of inputPath, committing each one to sink as
+// soon as it is done, then finishes the sink.
+void meshStep(const std::string& inputPath, const StepConvertOptions& options, mcguire::MeshSink& sink);
+
+// Moves OpenCASCADE's default message printers from stdout to stderr, so
+// that reader and mesher diagnostics stay out of meshes written to stdout.
+void sendStepMessagesToStderr();
+
+// Transfers the STEP file and writes its body list and assembly tree
+// (names, solid counts, bounding boxes and estimated triangle counts at
+// deflection) without tessellating anything. Each assembly node lists the
+// indices of the bodies it covers, for use with StepConvertOptions::bodies.
+void writeStepManifest(const std::string& inputPath, const std::string& outputPath, double deflection);
@@ -1,12 +1,18 @@
 #include <iostream>
+#include <memory>
 #include <string>
-#include <fstream>
 #include <algorithm>
-#include <nlohmann/json.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 
 #include "step_to_json.h"
 #include "stl_to_json.h"
 #include "obj_to_json.h"
+#include "json_passthrough.h"
+#include "mesh.h"
+#include "mesh_decimate.h"
+#include "mesh_sink.h"
 
 std::string toLower(const std::string& str) {
     std::string lowerStr = str;
@@ -21,51 +27,194 @@ std::string getExtension(const std::string& filename) {
     return toLower(filename.substr(dot));
 }
 
-bool isJsonFileValid(const std::string& path) {
-    try {
-        std::ifstream in(path);
-        if (!in) return false;
-        nlohmann::json j;
-        in >> j;
-        return j.contains("vertices") && (j.contains("tetrahedra") || j.contains("faces"));
-    } catch (...) {
-        return false;
+std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> items;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
     }
+    return items;
+}
+
+// Parses "linear[:angular],..." into LOD levels.
+std::vector<StepLodLevel> parseLodLevels(const std::string& value) {
+    std::vector<StepLodLevel> levels;
+    for (const auto& item : splitList(value)) {
+        StepLodLevel level;
+        size_t colon = item.find(':');
+        level.linearDeflection = std::stod(item.substr(0, colon));
+        if (colon != std::string::npos) {
+            level.angularDeflection = std::stod(item.substr(colon + 1));
+        }
+        if (!(level.linearDeflection > 0.0) || !(level.angularDeflection > 0.0)) {
+            throw std::invalid_argument("deflections must be positive");
+        }
+        levels.push_back(level);
+    }
+    return levels;
+}
+
+struct CliOptions {
+    std::string inputPath;
+    std::string outputPath;
+    bool manifest = false;
+    bool stream = false;
+    StepConvertOptions step;
+    mcguire::DecimateOptions decimate;
+    double targetRatio = 0.0;
+
+    bool decimating() const {
+        return decimate.targetTriangles > 0 || targetRatio > 0.0 || decimate.maxError > 0.0;
+    }
+};
+
+const char* kUsage =
+    "Usage: mcguire_step_cli [options] <input_file.step|.stl|.obj|.json> <output_file.json>\n"
+    "Options:\n"
+    "  --stream               write one NDJSON record per mesh as soon as it is ready,\n"
+    "                         followed by a trailer record; '-' writes to stdout\n"
+    "Options (STEP input only):\n"
+    "  --deflection <d>       linear deflection used for tessellation (default 0.1)\n"
+    "  --manifest             write the body list and assembly tree without meshing\n"
+    "  --bodies <i|name,...>  mesh only the listed bodies (manifest indices or names)\n"
+    "  --lod <lin[:ang],...>  mesh every body at each linear[:angular] deflection pair,\n"
+    "                         coarse to fine, into one output with per-level counts\n"
+    "Options (STL and OBJ input only):\n"
+    "  --target-triangles <n> decimate each mesh to at most n triangles\n"
+    "  --target-ratio <r>     decimate each mesh to this fraction of its triangles (0-1]\n"
+    "  --max-error <e>        stop before a collapse whose quadric error exceeds e: the\n"
+    "                         RMS distance (model units) to the planes of the faces it\n"
+    "                         merges, not a bound on the largest surface deviation;\n"
+    "                         combines with either target above";
+
+bool parseArguments(int argc, char** argv, CliOptions& options) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--manifest") {
+            options.manifest = true;
+        } else if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg == "--deflection" && i + 1 < argc) {
+            options.step.deflection = std::stod(argv[++i]);
+            if (!(options.step.deflection > 0.0)) return false;
+        } else if (arg == "--bodies" && i + 1 < argc) {
+            options.step.bodies = splitList(argv[++i]);
+        } else if (arg == "--lod" && i + 1 < argc) {
+            options.step.lods = parseLodLevels(argv[++i]);
+            if (options.step.lods.empty()) return false;
+        } else if (arg == "--target-triangles" && i + 1 < argc) {
+            long long n = std::stoll(argv[++i]);
+            if (n <= 0) return false;
+            options.decimate.targetTriangles = static_cast<size_t>(n);
+        } else if (arg == "--target-ratio" && i + 1 < argc) {
+            options.targetRatio = std::stod(argv[++i]);
+            if (!(options.targetRatio > 0.0) || options.targetRatio > 1.0) return false;
+        } else if (arg == "--max-error" && i + 1 < argc) {
+            options.decimate.maxError = std::stod(argv[++i]);
+            if (!(options.decimate.maxError > 0.0)) return false;
+        } else if (arg.rfind("--", 0) == 0) {
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (options.decimate.targetTriangles > 0 && options.targetRatio > 0.0) return false;
+    if (positional.size() != 2) return false;
+    options.inputPath = positional[0];
+    options.outputPath = positional[1];
+    return true;
 }
 
 int main(int argc, char** argv) {
-    if (argc < 3) {
-        std::cerr << "Usage: mcguire_step_cli <input_file.step|.stl|.obj|.json> <output_file.json>" << std::endl;
+    CliOptions options;
+    bool parsed = false;
+    try {
+        parsed = parseArguments(argc, argv, options);
+    } catch (const std::exception&) {
+        parsed = false;
+    }
+    if (!parsed) {
+        std::cerr << kUsage << std::endl;
         return 1;
     }
 
-    std::string inputPath = argv[1];
-    std::string outputPath = argv[2];
+    const std::string& inputPath = options.inputPath;
+    const std::string& outputPath = options.outputPath;
     std::string ext = getExtension(inputPath);
+    bool isStep = ext == ".step" || ext == ".stp";
+
+    // Keep stdout clean when the meshes themselves go there
+    std::ostream& status = outputPath == "-" ? std::cerr : std::cout;
+
+    if (!isStep && (options.manifest || !options.step.bodies.empty() || !options.step.lods.empty())) {
+        std::cerr << "❌ --manifest, --bodies and --lod are only supported for STEP input" << std::endl;
+        return 1;
+    }
+    if (options.decimating() && ext != ".stl" && ext != ".obj") {
+        std::cerr << "❌ --target-triangles, --target-ratio and --max-error are only supported for STL and OBJ input" << std::endl;
+        return 1;
+    }
+    if (options.stream && (options.manifest || ext == ".json")) {
+        std::cerr << "❌ --stream applies to STEP, STL and OBJ conversion only" << std::endl;
+        return 1;
+    }
+    if (outputPath == "-" && !options.stream) {
+        std::cerr << "❌ Writing to stdout ('-') requires --stream" << std::endl;
+        return 1;
+    }
 
     try {
-        if (ext == ".step" || ext == ".stp") {
-            convertStepToJson(inputPath, outputPath);
+        if (isStep && options.manifest) {
+            writeStepManifest(inputPath, outputPath, options.step.deflection);
+            status << "✅ Manifest written: " << outputPath << std::endl;
+            return 0;
+        } else if ((options.stream || options.decimating()) && (isStep || ext == ".stl" || ext == ".obj")) {
+            mcguire::MeshArena meshes;
+            std::unique_ptr<mcguire::MeshSink> sink;
+            if (options.stream) {
+                sink = std::make_unique<mcguire::NdjsonSink>(outputPath, meshes);
+            } else {
+                sink = std::make_unique<mcguire::DocumentSink>(outputPath, meshes,
+                                                               ext == ".stl" ? "mesh_0" : "default");
+            }
+            if (options.decimating()) {
+                sink->setMeshFilter([&](mcguire::Mesh& mesh) {
+                    mcguire::DecimateOptions decimate = options.decimate;
+                    if (options.targetRatio > 0.0) {
+                        decimate.targetTriangles = std::max<size_t>(
+                            1, static_cast<size_t>(mesh.triangleCount() * options.targetRatio));
+                    }
+                    mcguire::DecimateStats stats = mcguire::decimate(mesh, decimate);
+                    status << "🔻 Decimated " << (mesh.name.empty() ? "mesh" : mesh.name) << ": "
+                           << stats.trianglesBefore << " -> " << stats.trianglesAfter
+                           << " triangles (max error " << stats.maxError << ")" << std::endl;
+                });
+            }
+            if (isStep) {
+                if (outputPath == "-") sendStepMessagesToStderr();
+                meshStep(inputPath, options.step, *sink);
+            } else if (ext == ".stl") {
+                readStl(inputPath, *sink);
+            } else {
+                readObj(inputPath, *sink);
+            }
+        } else if (isStep) {
+            convertStepToJson(inputPath, outputPath, options.step);
         } else if (ext == ".stl") {
             convertStlToJson(inputPath, outputPath);
         } else if (ext == ".obj") {
             convertObjToJson(inputPath, outputPath);
         } else if (ext == ".json") {
-            if (isJsonFileValid(inputPath)) {
-                std::ifstream in(inputPath);
-                std::ofstream out(outputPath);
-                if (!out) throw std::runtime_error("Failed to open output file for writing");
-                out << in.rdbuf();
-                std::cout << "✅ Passed through valid .json file as mesh output" << std::endl;
-            } else {
-                throw std::runtime_error("Invalid or unsupported .json format: must contain 'vertices' and either 'faces' or 'tetrahedra'");
-            }
+            passThroughJson(inputPath, outputPath);
+            status << "✅ Passed through valid .json file as mesh output" << std::endl;
         } else {
             std::cerr << "❌ Unsupported file extension: " << ext << std::endl;
             return 2;
         }
 
-        std::cout << "✅ Conversion completed: " << outputPath << std::endl;
+        status << "✅ Conversion completed: " << outputPath << std::endl;
         return 0;
     } catch (const std::exception& e) {
         std::cerr << "❌ Error during conversion: " << e.what() << std::endl;
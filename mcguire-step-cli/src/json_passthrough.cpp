@@ -0,0 +1,277 @@
+// src/json_passthrough.cpp
+#include "json_passthrough.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr size_t kMaxDepth = 256;
+constexpr uint64_t kMaxEntries = std::numeric_limits<uint32_t>::max();
+constexpr size_t kReadBufferSize = 1 << 20;
+
+enum class Section { None, Vertices, Faces, Tetrahedra };
+
+const char* sectionName(Section s) {
+    switch (s) {
+        case Section::Vertices:   return "vertices";
+        case Section::Faces:      return "faces";
+        case Section::Tetrahedra: return "tetrahedra";
+        default:                  return "";
+    }
+}
+
+enum class Scalar { Other, Float, Negative, Unsigned };
+
+// SAX handler that checks the mesh arrays as they stream past. Returning
+// false from a callback aborts the parse. Once both arrays have passed, the
+// remaining events are accepted unchecked; the parser still reports syntax
+// errors and trailing input.
+class MeshJsonValidator : public nlohmann::json_sax<json> {
+public:
+    bool done() const { return done_; }
+    const std::string& error() const { return error_; }
+
+    bool null() override { return scalar(Scalar::Other, 0); }
+    bool boolean(bool) override { return scalar(Scalar::Other, 0); }
+    bool number_integer(number_integer_t v) override {
+        return v < 0 ? scalar(Scalar::Negative, 0) : scalar(Scalar::Unsigned, static_cast<uint64_t>(v));
+    }
+    bool number_unsigned(number_unsigned_t v) override { return scalar(Scalar::Unsigned, v); }
+    bool number_float(number_float_t, const string_t&) override { return scalar(Scalar::Float, 0); }
+    bool string(string_t&) override { return scalar(Scalar::Other, 0); }
+    bool binary(binary_t&) override { return scalar(Scalar::Other, 0); }
+
+    bool start_object(std::size_t) override { return start(false); }
+    bool end_object() override { return end(); }
+    bool start_array(std::size_t) override { return start(true); }
+    bool end_array() override { return end(); }
+
+    bool key(string_t& name) override {
+        if (depth_ == 1) {
+            if (name == "vertices") pending_ = Section::Vertices;
+            else if (name == "faces") pending_ = Section::Faces;
+            else if (name == "tetrahedra") pending_ = Section::Tetrahedra;
+            else pending_ = Section::None;
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        return fail(ex.what());
+    }
+
+private:
+    bool fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+
+    bool scalar(Scalar kind, uint64_t value) {
+        if (done_) return true;
+        if (depth_ == 0) return fail("top level must be an object");
+        if (depth_ == 1) {
+            if (pending_ != Section::None) {
+                return fail(std::string("'") + sectionName(pending_) + "' must be an array");
+            }
+            return true;
+        }
+        if (active_ == Section::None) return true;
+        if (depth_ == 2) {
+            return fail(std::string("each entry of '") + sectionName(active_) + "' must be an array");
+        }
+
+        // depth_ == 3: one component of a vertex or an index of a cell
+        if (active_ == Section::Vertices) {
+            if (kind == Scalar::Other) return fail("vertex coordinates must be numbers");
+        } else {
+            if (kind != Scalar::Unsigned) {
+                return fail(std::string("'") + sectionName(active_) + "' must hold non-negative integer indices");
+            }
+            maxIndex_ = std::max(maxIndex_, value);
+            sawIndex_ = true;
+        }
+        ++components_;
+        return true;
+    }
+
+    bool start(bool isArray) {
+        if (done_) return true;
+        if (depth_ == 0 && !isArray) {
+            depth_ = 1;
+            return true;
+        }
+        if (depth_ == 0) return fail("top level must be an object");
+
+        if (depth_ == 1 && pending_ != Section::None) {
+            if (!isArray) return fail(std::string("'") + sectionName(pending_) + "' must be an array");
+            active_ = pending_;
+            pending_ = Section::None;
+            entries_ = 0;
+        } else if (active_ != Section::None) {
+            if (depth_ == 3 || !isArray) {
+                return fail(std::string("entries of '") + sectionName(active_) + "' must be flat arrays");
+            }
+            components_ = 0;
+        }
+
+        if (++depth_ > kMaxDepth) return fail("document nested too deeply");
+        return true;
+    }
+
+    bool end() {
+        if (done_) return true;
+        if (active_ != Section::None && depth_ == 3) {
+            bool ok = active_ == Section::Vertices   ? components_ == 3
+                    : active_ == Section::Tetrahedra ? components_ == 4
+                                                     : components_ >= 3;
+            if (!ok) return fail(std::string("malformed entry in '") + sectionName(active_) + "'");
+            if (++entries_ > kMaxEntries) {
+                return fail(std::string("'") + sectionName(active_) + "' exceeds the supported size");
+            }
+        } else if (active_ != Section::None && depth_ == 2) {
+            if (active_ == Section::Vertices) {
+                haveVertices_ = true;
+                vertexCount_ = entries_;
+            } else {
+                haveCells_ = true;
+            }
+            active_ = Section::None;
+
+            if (haveVertices_ && haveCells_) {
+                if (sawIndex_ && maxIndex_ >= vertexCount_) return fail("index out of range of 'vertices'");
+                done_ = true;
+            }
+        }
+        --depth_;
+        return true;
+    }
+
+    size_t depth_ = 0;
+    Section pending_ = Section::None;
+    Section active_ = Section::None;
+    uint64_t entries_ = 0;
+    size_t components_ = 0;
+    uint64_t vertexCount_ = 0;
+    uint64_t maxIndex_ = 0;
+    bool sawIndex_ = false;
+    bool haveVertices_ = false;
+    bool haveCells_ = false;
+    bool done_ = false;
+    std::string error_;
+};
+
+#if defined(__linux__)
+// Copies with copy_file_range (reflink or in-kernel copy), falling back to
+// sendfile where the filesystems don't support it or it stops short.
+// Returns false if neither copied the whole file, in which case the caller
+// falls back to a userspace copy.
+bool kernelCopy(const std::string& inputPath, const std::string& outputPath) {
+    int in = ::open(inputPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+    struct stat st;
+    if (::fstat(in, &st) != 0) {
+        ::close(in);
+        return false;
+    }
+    int out = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    off_t remaining = st.st_size;
+    bool useCopyRange = true;
+    bool ok = true;
+    while (remaining > 0) {
+        ssize_t n;
+        if (useCopyRange) {
+            n = ::copy_file_range(in, nullptr, out, nullptr, static_cast<size_t>(remaining), 0);
+            if (n < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+                useCopyRange = false;
+                continue;
+            }
+        } else {
+            n = ::sendfile(out, in, nullptr, static_cast<size_t>(remaining));
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            // Some filesystems return 0 from copy_file_range instead of an
+            // error; give sendfile a chance, then leave it to the caller
+            if (useCopyRange) {
+                useCopyRange = false;
+                continue;
+            }
+            ok = false;
+            break;
+        }
+        remaining -= n;
+    }
+
+    if (::close(out) != 0) ok = false;
+    ::close(in);
+    return ok;
+}
+#endif
+
+} // namespace
+
+bool isJsonFileValid(const std::string& inputPath, std::string* reason) {
+    std::vector<char> buffer(kReadBufferSize);
+    std::ifstream in;
+    in.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    in.open(inputPath, std::ios::binary);
+    if (!in) {
+        if (reason) *reason = "cannot open file";
+        return false;
+    }
+
+    MeshJsonValidator validator;
+    bool parsed = json::sax_parse(in, &validator);
+    if (parsed && validator.done()) return true;
+
+    if (reason) {
+        *reason = validator.error().empty()
+            ? "must contain 'vertices' and either 'faces' or 'tetrahedra'"
+            : validator.error();
+    }
+    return false;
+}
+
+void passThroughJson(const std::string& inputPath, const std::string& outputPath) {
+    std::string reason;
+    if (!isJsonFileValid(inputPath, &reason)) {
+        throw std::runtime_error("Invalid or unsupported .json format: " + reason);
+    }
+
+    // The caller can use the input in place
+    std::error_code ec;
+    if (std::filesystem::equivalent(inputPath, outputPath, ec)) return;
+
+#if defined(__linux__)
+    if (kernelCopy(inputPath, outputPath)) return;
+#endif
+
+    std::filesystem::copy_file(inputPath, outputPath,
+                               std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec) throw std::runtime_error("Failed to copy .json file: " + ec.message());
+}
@@ -0,0 +1,147 @@
+// src/mesh.cpp
+#include "mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace mcguire {
+
+namespace {
+
+constexpr uint32_t kNoVertex = std::numeric_limits<uint32_t>::max();
+
+// Cells are much larger than the tolerance so that most points only have
+// to look at their own cell.
+constexpr double kCellsPerTolerance = 16.0;
+
+int64_t bitsOf(double v) {
+    if (v == 0.0) v = 0.0; // fold -0.0 into +0.0
+    int64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+void Mesh::reserve(size_t vertices, size_t triangles) {
+    x.reserve(vertices);
+    y.reserve(vertices);
+    z.reserve(vertices);
+    indices.reserve(triangles * 3);
+}
+
+void Mesh::clear() {
+    name.clear();
+    x.clear();
+    y.clear();
+    z.clear();
+    indices.clear();
+}
+
+Mesh& MeshArena::acquire(const std::string& name) {
+    if (used_ == pool_.size()) {
+        pool_.emplace_back();
+    }
+    Mesh& mesh = pool_[used_++];
+    mesh.clear();
+    mesh.name = name;
+    return mesh;
+}
+
+void MeshArena::discardLast() {
+    if (used_ > 0) {
+        pool_[--used_].clear();
+    }
+}
+
+void MeshArena::reset() {
+    for (size_t i = 0; i < used_; ++i) {
+        pool_[i].clear();
+    }
+    used_ = 0;
+}
+
+size_t VertexWelder::CellHash::operator()(const CellKey& key) const {
+    uint64_t h = static_cast<uint64_t>(key.i) * 0x9E3779B97F4A7C15ull;
+    h ^= static_cast<uint64_t>(key.j) + 0x7F4A7C159E3779B9ull + (h << 6) + (h >> 2);
+    h ^= static_cast<uint64_t>(key.k) + 0x94D049BB133111EBull + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    return static_cast<size_t>(h);
+}
+
+VertexWelder::VertexWelder(double tolerance)
+    : tolerance_(tolerance > 0.0 ? tolerance : 0.0),
+      cellSize_(tolerance > 0.0 ? tolerance * kCellsPerTolerance : 0.0) {}
+
+void VertexWelder::begin(Mesh& mesh, size_t expectedVertices) {
+    mesh_ = &mesh;
+    heads_.clear();
+    next_.clear();
+    if (expectedVertices > 0) {
+        heads_.reserve(expectedVertices);
+        next_.reserve(expectedVertices);
+    }
+    // Vertices already in the mesh take part in welding too.
+    for (size_t v = 0; v < mesh.vertexCount(); ++v) {
+        CellKey key = cellOf(mesh.x[v], mesh.y[v], mesh.z[v]);
+        auto [it, inserted] = heads_.emplace(key, static_cast<uint32_t>(v));
+        next_.push_back(inserted ? kNoVertex : it->second);
+        it->second = static_cast<uint32_t>(v);
+    }
+}
+
+VertexWelder::CellKey VertexWelder::cellOf(double px, double py, double pz) const {
+    if (cellSize_ == 0.0) {
+        return {bitsOf(px), bitsOf(py), bitsOf(pz)};
+    }
+    return {static_cast<int64_t>(std::floor(px / cellSize_)),
+            static_cast<int64_t>(std::floor(py / cellSize_)),
+            static_cast<int64_t>(std::floor(pz / cellSize_))};
+}
+
+bool VertexWelder::findInCell(const CellKey& key, double px, double py, double pz,
+                              uint32_t& found) const {
+    auto it = heads_.find(key);
+    if (it == heads_.end()) return false;
+    const Mesh& m = *mesh_;
+    for (uint32_t v = it->second; v != kNoVertex; v = next_[v]) {
+        if (std::abs(m.x[v] - px) <= tolerance_ &&
+            std::abs(m.y[v] - py) <= tolerance_ &&
+            std::abs(m.z[v] - pz) <= tolerance_) {
+            found = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t VertexWelder::weld(double px, double py, double pz) {
+    CellKey home = cellOf(px, py, pz);
+    uint32_t found;
+
+    if (findInCell(home, px, py, pz, found)) return found;
+
+    if (cellSize_ > 0.0) {
+        // A match may sit just across a cell boundary.
+        CellKey lo = cellOf(px - tolerance_, py - tolerance_, pz - tolerance_);
+        CellKey hi = cellOf(px + tolerance_, py + tolerance_, pz + tolerance_);
+        for (int64_t i = lo.i; i <= hi.i; ++i) {
+            for (int64_t j = lo.j; j <= hi.j; ++j) {
+                for (int64_t k = lo.k; k <= hi.k; ++k) {
+                    CellKey key{i, j, k};
+                    if (key == home) continue;
+                    if (findInCell(key, px, py, pz, found)) return found;
+                }
+            }
+        }
+    }
+
+    uint32_t id = mesh_->addVertex(px, py, pz);
+    auto [it, inserted] = heads_.emplace(home, id);
+    next_.push_back(inserted ? kNoVertex : it->second);
+    it->second = id;
+    return id;
+}
+
+} // namespace mcguire
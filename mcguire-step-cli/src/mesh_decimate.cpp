@@ -0,0 +1,645 @@
+// src/mesh_decimate.cpp
+#include "mesh_decimate.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mcguire {
+
+namespace {
+
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+// Below this size the clustered pass costs more than it saves.
+constexpr size_t kMinParallelTriangles = 200000;
+constexpr unsigned kClustersPerThread = 4;
+
+// A cluster's locked border stays at full density until the serial pass, so
+// its interior is never taken below this many triangles per border vertex;
+// otherwise it would be starved to make up for the border.
+constexpr size_t kTrianglesPerBorderVertex = 4;
+
+// Weight of the plane that holds an open edge in place when boundaries are
+// allowed to move.
+constexpr double kBoundaryWeight = 100.0;
+
+// Lock bits per vertex.
+constexpr uint8_t kLockBoundary = 1; // open or non-manifold edge, kept for good
+constexpr uint8_t kLockCluster = 2;  // touches another cluster, parallel pass only
+
+struct Vec3 {
+    double x, y, z;
+};
+
+Vec3 sub(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+double dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+Vec3 cross(const Vec3& a, const Vec3& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+// Symmetric 4x4 plane quadric plus the total weight of its planes, so that
+// evaluate() / w is a mean squared distance.
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0, w = 0;
+
+    void addPlane(const Vec3& n, double d, double weight) {
+        a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+        b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+        c2 += weight * n.z * n.z; cd += weight * n.z * d;
+        d2 += weight * d * d;
+        w += weight;
+    }
+
+    Quadric& operator+=(const Quadric& o) {
+        a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad;
+        b2 += o.b2; bc += o.bc; bd += o.bd;
+        c2 += o.c2; cd += o.cd;
+        d2 += o.d2; w += o.w;
+        return *this;
+    }
+
+    double evaluate(const Vec3& p) const {
+        return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+             + b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+             + c2 * p.z * p.z + 2 * cd * p.z
+             + d2;
+    }
+
+    double error(const Vec3& p) const {
+        return w > 0 ? std::max(0.0, evaluate(p)) / w : 0.0;
+    }
+
+    // Point minimising the quadric, if the system is well conditioned.
+    bool optimum(Vec3& p) const {
+        double det = a2 * (b2 * c2 - bc * bc) - ab * (ab * c2 - bc * ac) + ac * (ab * bc - b2 * ac);
+        double scale = a2 + b2 + c2;
+        if (std::abs(det) <= 1e-10 * scale * scale * scale) return false;
+        double inv = 1.0 / det;
+        p.x = -inv * (ad * (b2 * c2 - bc * bc) - ab * (bd * c2 - bc * cd) + ac * (bd * bc - b2 * cd));
+        p.y = -inv * (a2 * (bd * c2 - cd * bc) - ad * (ab * c2 - bc * ac) + ac * (ab * cd - bd * ac));
+        p.z = -inv * (a2 * (b2 * cd - bc * bd) - ab * (ab * cd - bd * ac) + ad * (ab * bc - b2 * ac));
+        return true;
+    }
+};
+
+// Heap entry. Kept small for cache reasons; the target position is
+// recomputed when the entry reaches the top and is still current.
+struct Candidate {
+    double cost;
+    float length; // squared edge length, breaks ties on flat regions
+    uint32_t from, to;
+    uint32_t fromVersion, toVersion;
+};
+
+struct Collapse {
+    uint32_t from, to;
+    Vec3 target;
+    double cost;
+    double length;
+};
+
+struct Cluster {
+    std::vector<uint32_t> faces; // faces with all three vertices inside
+    size_t borderVertices = 0;
+};
+
+struct CandidateOrder {
+    // Equal costs are common on planar CAD faces; collapsing the shortest
+    // edge first keeps them from degenerating into one growing fan
+    bool operator()(const Candidate& a, const Candidate& b) const {
+        return a.cost > b.cost || (a.cost == b.cost && a.length > b.length);
+    }
+};
+
+// Per-thread state. Everything shared lives in Decimator and is only ever
+// touched for vertices and faces of the worker's own cluster.
+struct Worker {
+    std::vector<Candidate> heap;
+    std::vector<uint32_t> around;  // neighbours of one endpoint
+    std::vector<uint32_t> around2; // neighbours of the other endpoint
+    std::vector<uint32_t> faces;   // live faces of a vertex being repacked
+    std::vector<std::pair<uint32_t, uint32_t>> opposite; // edges opposite one endpoint
+    size_t liveTriangles = 0;
+    double maxCost = 0.0;
+};
+
+class Decimator {
+public:
+    Decimator(Mesh& mesh, const DecimateOptions& options) : mesh_(mesh), options_(options) {}
+
+    DecimateStats run();
+
+private:
+    Vec3 position(uint32_t v) const { return {mesh_.x[v], mesh_.y[v], mesh_.z[v]}; }
+    uint32_t* face(uint32_t f) { return &mesh_.indices[size_t(f) * 3]; }
+    const uint32_t* face(uint32_t f) const { return &mesh_.indices[size_t(f) * 3]; }
+
+    template <typename Fn>
+    void forEachFace(uint32_t v, Fn&& fn) const {
+        // Faces of v are spread over the face slots of every vertex merged
+        // into it; dead ones are skipped, live ones have been rewritten to use v.
+        for (uint32_t w = v; w != kNone; w = chainNext_[w]) {
+            for (uint32_t k = faceStart_[w]; k < faceEnd_[w]; ++k) {
+                uint32_t f = faceList_[k];
+                if (faceAlive_[f]) fn(f);
+            }
+        }
+    }
+
+    void buildAdjacency();
+    void classifyVertices(size_t begin, size_t end);
+    void buildQuadrics();
+    void partition(unsigned count, std::vector<Cluster>& clusters);
+
+    void neighbours(uint32_t v, std::vector<uint32_t>& out) const;
+    bool plan(uint32_t a, uint32_t b, Collapse& c) const;
+    Candidate candidate(const Collapse& c) const {
+        return {c.cost, static_cast<float>(c.length), c.from, c.to, version_[c.from], version_[c.to]};
+    }
+    void pushCandidate(uint32_t a, uint32_t b, Worker& worker) const;
+    bool canCollapse(const Collapse& c, Worker& worker) const;
+    void collapse(const Collapse& c, Worker& worker);
+    void repack(uint32_t v, Worker& worker);
+    void decimateRegion(const std::vector<uint32_t>& faces, size_t target, Worker& worker);
+    void compact();
+
+    Mesh& mesh_;
+    DecimateOptions options_;
+    double maxCost_ = std::numeric_limits<double>::infinity();
+
+    std::vector<uint32_t> faceStart_, faceList_; // vertex -> original faces (CSR)
+    std::vector<uint32_t> faceEnd_;               // end of the slots still in use
+    std::vector<uint32_t> chainNext_, chainTail_; // vertices merged into each vertex
+    std::vector<uint32_t> version_;
+    std::vector<uint8_t> faceAlive_, vertexAlive_, lock_;
+    std::vector<uint8_t> boundary_; // vertex on an open edge
+    std::vector<Quadric> quadrics_;
+};
+
+void Decimator::buildAdjacency() {
+    const size_t vertexCount = mesh_.vertexCount();
+    const size_t faceCount = mesh_.triangleCount();
+
+    faceAlive_.assign(faceCount, 1);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        const uint32_t* t = face(f);
+        if (t[0] == t[1] || t[1] == t[2] || t[0] == t[2]) faceAlive_[f] = 0;
+    }
+
+    faceStart_.assign(vertexCount + 1, 0);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (!faceAlive_[f]) continue;
+        const uint32_t* t = face(f);
+        for (int k = 0; k < 3; ++k) ++faceStart_[t[k] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) faceStart_[v + 1] += faceStart_[v];
+
+    faceList_.resize(faceStart_[vertexCount]);
+    std::vector<uint32_t> fill(faceStart_.begin(), faceStart_.end() - 1);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (!faceAlive_[f]) continue;
+        const uint32_t* t = face(f);
+        for (int k = 0; k < 3; ++k) faceList_[fill[t[k]]++] = f;
+    }
+
+    faceEnd_.assign(faceStart_.begin() + 1, faceStart_.end());
+    chainNext_.assign(vertexCount, kNone);
+    chainTail_.resize(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) chainTail_[v] = v;
+    version_.assign(vertexCount, 0);
+    vertexAlive_.assign(vertexCount, 1);
+    lock_.assign(vertexCount, 0);
+    boundary_.assign(vertexCount, 0);
+    quadrics_.assign(vertexCount, Quadric());
+}
+
+// Locks vertices on open or non-manifold edges and, when boundaries may
+// move, adds the planes that keep open edges from drifting sideways.
+void Decimator::classifyVertices(size_t begin, size_t end) {
+    std::vector<std::pair<uint32_t, uint32_t>> edgeUse; // other vertex, use count
+    for (size_t v = begin; v < end; ++v) {
+        edgeUse.clear();
+        for (uint32_t k = faceStart_[v]; k < faceStart_[v + 1]; ++k) {
+            const uint32_t* t = face(faceList_[k]);
+            for (int j = 0; j < 3; ++j) {
+                if (t[j] == v) continue;
+                auto it = std::find_if(edgeUse.begin(), edgeUse.end(),
+                                       [&](const auto& e) { return e.first == t[j]; });
+                if (it == edgeUse.end()) edgeUse.emplace_back(t[j], 1);
+                else ++it->second;
+            }
+        }
+        for (const auto& [other, uses] : edgeUse) {
+            if (uses > 2) {
+                lock_[v] |= kLockBoundary;
+            } else if (uses == 1) {
+                boundary_[v] = 1;
+                if (options_.preserveBoundary) {
+                    lock_[v] |= kLockBoundary;
+                    continue;
+                }
+                // Plane through the open edge, perpendicular to its face
+                for (uint32_t k = faceStart_[v]; k < faceStart_[v + 1]; ++k) {
+                    const uint32_t* t = face(faceList_[k]);
+                    if (t[0] != other && t[1] != other && t[2] != other) continue;
+                    Vec3 p0 = position(t[0]), p1 = position(t[1]), p2 = position(t[2]);
+                    Vec3 normal = cross(sub(p1, p0), sub(p2, p0));
+                    Vec3 edge = sub(position(other), position(static_cast<uint32_t>(v)));
+                    Vec3 n = cross(edge, normal);
+                    double len = std::sqrt(dot(n, n));
+                    if (len <= 0) break;
+                    n = {n.x / len, n.y / len, n.z / len};
+                    quadrics_[v].addPlane(n, -dot(n, position(static_cast<uint32_t>(v))),
+                                          kBoundaryWeight * dot(edge, edge));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void Decimator::buildQuadrics() {
+    for (uint32_t f = 0; f < mesh_.triangleCount(); ++f) {
+        if (!faceAlive_[f]) continue;
+        const uint32_t* t = face(f);
+        Vec3 p0 = position(t[0]);
+        Vec3 n = cross(sub(position(t[1]), p0), sub(position(t[2]), p0));
+        double len = std::sqrt(dot(n, n));
+        if (len <= 0) continue;
+        n = {n.x / len, n.y / len, n.z / len};
+        double d = -dot(n, p0);
+        for (int k = 0; k < 3; ++k) quadrics_[t[k]].addPlane(n, d, 0.5 * len);
+    }
+}
+
+// Assigns vertices to a grid of roughly the requested number of clusters,
+// collects the faces that lie entirely inside each one and locks every
+// vertex of a face that straddles two clusters.
+void Decimator::partition(unsigned count, std::vector<Cluster>& clusters) {
+    Vec3 lo{mesh_.x[0], mesh_.y[0], mesh_.z[0]}, hi = lo;
+    for (size_t v = 1; v < mesh_.vertexCount(); ++v) {
+        lo = {std::min(lo.x, mesh_.x[v]), std::min(lo.y, mesh_.y[v]), std::min(lo.z, mesh_.z[v])};
+        hi = {std::max(hi.x, mesh_.x[v]), std::max(hi.y, mesh_.y[v]), std::max(hi.z, mesh_.z[v])};
+    }
+    const int cells = std::max(1, static_cast<int>(std::ceil(std::cbrt(double(count)))));
+    auto cellOf = [&](double value, double min, double max) {
+        if (max <= min) return 0;
+        int c = static_cast<int>((value - min) / (max - min) * cells);
+        return std::min(std::max(c, 0), cells - 1);
+    };
+
+    std::vector<uint32_t> cluster(mesh_.vertexCount());
+    for (size_t v = 0; v < mesh_.vertexCount(); ++v) {
+        cluster[v] = static_cast<uint32_t>(
+            (cellOf(mesh_.x[v], lo.x, hi.x) * cells + cellOf(mesh_.y[v], lo.y, hi.y)) * cells +
+            cellOf(mesh_.z[v], lo.z, hi.z));
+    }
+
+    clusters.assign(size_t(cells) * cells * cells, Cluster());
+    for (uint32_t f = 0; f < mesh_.triangleCount(); ++f) {
+        if (!faceAlive_[f]) continue;
+        const uint32_t* t = face(f);
+        uint32_t c = cluster[t[0]];
+        if (cluster[t[1]] == c && cluster[t[2]] == c) {
+            clusters[c].faces.push_back(f);
+            continue;
+        }
+        for (int k = 0; k < 3; ++k) {
+            if (lock_[t[k]] & kLockCluster) continue;
+            lock_[t[k]] |= kLockCluster;
+            ++clusters[cluster[t[k]]].borderVertices;
+        }
+    }
+}
+
+void Decimator::neighbours(uint32_t v, std::vector<uint32_t>& out) const {
+    out.clear();
+    forEachFace(v, [&](uint32_t f) {
+        const uint32_t* t = face(f);
+        for (int k = 0; k < 3; ++k) {
+            if (t[k] != v && std::find(out.begin(), out.end(), t[k]) == out.end()) out.push_back(t[k]);
+        }
+    });
+}
+
+bool Decimator::plan(uint32_t a, uint32_t b, Collapse& c) const {
+    const bool lockedA = lock_[a] != 0;
+    const bool lockedB = lock_[b] != 0;
+    if (lockedA && lockedB) return false;
+
+    Quadric q = quadrics_[a];
+    q += quadrics_[b];
+
+    // A locked endpoint stays where it is and absorbs the other one
+    if (lockedA || lockedB) {
+        c.from = lockedA ? b : a;
+        c.to = lockedA ? a : b;
+        c.target = position(c.to);
+    } else {
+        c.from = a;
+        c.to = b;
+        Vec3 pa = position(a), pb = position(b);
+        Vec3 mid{(pa.x + pb.x) / 2, (pa.y + pb.y) / 2, (pa.z + pb.z) / 2};
+        Vec3 edge = sub(pb, pa);
+        Vec3 best;
+        bool solved = q.optimum(best);
+        // An optimum far outside the edge comes from a nearly singular system
+        if (!solved || dot(sub(best, mid), sub(best, mid)) > 4 * dot(edge, edge)) {
+            best = pa;
+            if (q.evaluate(pb) < q.evaluate(best)) best = pb;
+            if (q.evaluate(mid) < q.evaluate(best)) best = mid;
+        }
+        c.target = best;
+    }
+
+    c.cost = q.error(c.target);
+    Vec3 edge = sub(position(a), position(b));
+    c.length = dot(edge, edge);
+    return true;
+}
+
+void Decimator::pushCandidate(uint32_t a, uint32_t b, Worker& worker) const {
+    Collapse c;
+    if (!plan(a, b, c)) return;
+    worker.heap.push_back(candidate(c));
+    std::push_heap(worker.heap.begin(), worker.heap.end(), CandidateOrder());
+}
+
+bool Decimator::canCollapse(const Collapse& c, Worker& worker) const {
+    // Link condition: the endpoints may only share the neighbours opposite
+    // the edge, otherwise the collapse pinches the surface
+    neighbours(c.from, worker.around);
+    neighbours(c.to, worker.around2);
+    size_t shared = 0;
+    forEachFace(c.from, [&](uint32_t f) {
+        const uint32_t* t = face(f);
+        if (t[0] == c.to || t[1] == c.to || t[2] == c.to) ++shared;
+    });
+    if (shared == 0 || shared > 2) return false;
+    // An interior edge between two boundary vertices would pinch the
+    // surface into a bowtie at the merged vertex
+    if (boundary_[c.from] && boundary_[c.to] && shared != 1) return false;
+    size_t common = 0;
+    for (uint32_t n : worker.around) {
+        if (n != c.to && std::find(worker.around2.begin(), worker.around2.end(), n) != worker.around2.end()) {
+            ++common;
+        }
+    }
+    if (common != shared) return false;
+
+    // Edge part of the link condition: an edge opposite both endpoints in
+    // faces outside the collapsing ones would turn those two faces into
+    // duplicates. This is what stops a closed part at a tetrahedron.
+    auto oppositeEdge = [](const uint32_t* t, uint32_t v) {
+        uint32_t a = t[0] == v ? t[1] : t[0];
+        uint32_t b = t[2] == v ? t[1] : t[2];
+        return std::make_pair(std::min(a, b), std::max(a, b));
+    };
+    worker.opposite.clear();
+    forEachFace(c.to, [&](uint32_t f) {
+        const uint32_t* t = face(f);
+        if (t[0] != c.from && t[1] != c.from && t[2] != c.from) worker.opposite.push_back(oppositeEdge(t, c.to));
+    });
+    bool duplicate = false;
+    forEachFace(c.from, [&](uint32_t f) {
+        const uint32_t* t = face(f);
+        if (duplicate || t[0] == c.to || t[1] == c.to || t[2] == c.to) return;
+        auto edge = oppositeEdge(t, c.from);
+        duplicate = std::find(worker.opposite.begin(), worker.opposite.end(), edge) != worker.opposite.end();
+    });
+    if (duplicate) return false;
+
+    // No surviving face may flip or collapse to a sliver
+    bool ok = true;
+    auto check = [&](uint32_t moved, uint32_t other) {
+        forEachFace(moved, [&](uint32_t f) {
+            if (!ok) return;
+            const uint32_t* t = face(f);
+            if (t[0] == other || t[1] == other || t[2] == other) return;
+            Vec3 p[3], q[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = position(t[k]);
+                q[k] = t[k] == moved ? c.target : p[k];
+            }
+            Vec3 before = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+            Vec3 after = cross(sub(q[1], q[0]), sub(q[2], q[0]));
+            double d = dot(before, after);
+            if (d <= 0 || dot(after, after) <= 1e-12 * dot(before, before)) ok = false;
+        });
+    };
+    check(c.from, c.to);
+    check(c.to, c.from);
+    return ok;
+}
+
+void Decimator::collapse(const Collapse& c, Worker& worker) {
+    const uint32_t from = c.from, to = c.to;
+
+    // Locked vertices keep their position and may be read by a neighbouring
+    // cluster, so they are not written at all
+    if (!lock_[to]) {
+        mesh_.x[to] = c.target.x;
+        mesh_.y[to] = c.target.y;
+        mesh_.z[to] = c.target.z;
+    }
+    quadrics_[to] += quadrics_[from];
+    if (boundary_[from] && !boundary_[to]) boundary_[to] = 1;
+
+    forEachFace(from, [&](uint32_t f) {
+        uint32_t* t = face(f);
+        if (t[0] == to || t[1] == to || t[2] == to) {
+            faceAlive_[f] = 0;
+            --worker.liveTriangles;
+        } else {
+            for (int k = 0; k < 3; ++k) {
+                if (t[k] == from) t[k] = to;
+            }
+        }
+    });
+
+    chainNext_[chainTail_[to]] = from;
+    chainTail_[to] = chainTail_[from];
+    vertexAlive_[from] = 0;
+    ++version_[from];
+    ++version_[to];
+    worker.maxCost = std::max(worker.maxCost, c.cost);
+
+    repack(to, worker);
+
+    neighbours(to, worker.around);
+    for (uint32_t n : worker.around) pushCandidate(to, n, worker);
+}
+
+// Moves the live faces of v to the front of its chain of face slots and
+// drops the chain links that are no longer needed, so that walking the
+// faces of a vertex stays proportional to its valence.
+void Decimator::repack(uint32_t v, Worker& worker) {
+    worker.faces.clear();
+    forEachFace(v, [&](uint32_t f) { worker.faces.push_back(f); });
+
+    size_t i = 0;
+    uint32_t w = v;
+    for (;;) {
+        uint32_t k = faceStart_[w];
+        for (; k < faceStart_[w + 1] && i < worker.faces.size(); ++k) faceList_[k] = worker.faces[i++];
+        faceEnd_[w] = k;
+        if (i == worker.faces.size() || chainNext_[w] == kNone) break;
+        w = chainNext_[w];
+    }
+    chainNext_[w] = kNone;
+    chainTail_[v] = w;
+}
+
+void Decimator::decimateRegion(const std::vector<uint32_t>& faces, size_t target, Worker& worker) {
+    worker.heap.clear();
+    for (uint32_t f : faces) {
+        const uint32_t* t = face(f);
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = t[k], b = t[(k + 1) % 3];
+            Collapse c;
+            if (a < b && plan(a, b, c)) {
+                worker.heap.push_back(candidate(c));
+            }
+        }
+    }
+    std::make_heap(worker.heap.begin(), worker.heap.end(), CandidateOrder());
+
+    while (!worker.heap.empty() && worker.liveTriangles > target) {
+        std::pop_heap(worker.heap.begin(), worker.heap.end(), CandidateOrder());
+        Candidate top = worker.heap.back();
+        worker.heap.pop_back();
+
+        if (!vertexAlive_[top.from] || !vertexAlive_[top.to]) continue;
+        if (version_[top.from] != top.fromVersion || version_[top.to] != top.toVersion) continue;
+        if (top.cost > maxCost_) break;
+        Collapse c;
+        if (!plan(top.from, top.to, c) || !canCollapse(c, worker)) continue;
+        collapse(c, worker);
+    }
+}
+
+void Decimator::compact() {
+    std::vector<uint32_t> remap(mesh_.vertexCount(), kNone);
+    size_t vertexCount = 0;
+    size_t faceCount = 0;
+    for (uint32_t f = 0; f < mesh_.triangleCount(); ++f) {
+        if (!faceAlive_[f]) continue;
+        const uint32_t* t = face(f);
+        uint32_t* out = &mesh_.indices[faceCount * 3];
+        for (int k = 0; k < 3; ++k) {
+            if (remap[t[k]] == kNone) remap[t[k]] = static_cast<uint32_t>(vertexCount++);
+            out[k] = remap[t[k]];
+        }
+        ++faceCount;
+    }
+    mesh_.indices.resize(faceCount * 3);
+
+    // Renumbered in first-use order, so positions move only towards the front
+    std::vector<double> x(vertexCount), y(vertexCount), z(vertexCount);
+    for (size_t v = 0; v < remap.size(); ++v) {
+        if (remap[v] == kNone) continue;
+        x[remap[v]] = mesh_.x[v];
+        y[remap[v]] = mesh_.y[v];
+        z[remap[v]] = mesh_.z[v];
+    }
+    mesh_.x.swap(x);
+    mesh_.y.swap(y);
+    mesh_.z.swap(z);
+}
+
+DecimateStats Decimator::run() {
+    DecimateStats stats;
+    stats.trianglesBefore = stats.trianglesAfter = mesh_.triangleCount();
+    stats.verticesBefore = stats.verticesAfter = mesh_.vertexCount();
+    if (mesh_.triangleCount() == 0) return stats;
+    if (options_.targetTriangles == 0 && options_.maxError <= 0) return stats;
+    if (options_.targetTriangles >= mesh_.triangleCount() && options_.maxError <= 0) return stats;
+    if (options_.maxError > 0) maxCost_ = options_.maxError * options_.maxError;
+
+    buildAdjacency();
+    buildQuadrics();
+
+    unsigned threads = options_.threads ? options_.threads : std::thread::hardware_concurrency();
+    threads = std::max(1u, threads);
+
+    // Vertex classification only reads shared data, so it splits by range
+    {
+        std::vector<std::thread> pool;
+        const size_t n = mesh_.vertexCount();
+        const size_t chunk = (n + threads - 1) / threads;
+        for (unsigned i = 0; i < threads; ++i) {
+            size_t begin = std::min(n, i * chunk), end = std::min(n, begin + chunk);
+            if (begin < end) pool.emplace_back([this, begin, end] { classifyVertices(begin, end); });
+        }
+        for (auto& t : pool) t.join();
+    }
+
+    size_t live = std::count(faceAlive_.begin(), faceAlive_.end(), uint8_t(1));
+    const size_t target = options_.targetTriangles;
+    double maxCost = 0.0;
+
+    if (threads > 1 && live >= kMinParallelTriangles) {
+        std::vector<Cluster> clusters;
+        partition(threads * kClustersPerThread, clusters);
+
+        std::atomic<size_t> next{0};
+        std::vector<Worker> workers(threads);
+        std::vector<size_t> removed(threads, 0);
+        std::vector<std::thread> pool;
+        for (unsigned i = 0; i < threads; ++i) {
+            pool.emplace_back([&, i] {
+                Worker& worker = workers[i];
+                for (size_t c; (c = next.fetch_add(1)) < clusters.size();) {
+                    const auto& faces = clusters[c].faces;
+                    if (faces.empty()) continue;
+                    // Each cluster aims for its share of the overall target
+                    size_t share = static_cast<size_t>(double(target) * faces.size() / live);
+                    share = std::max(share, kTrianglesPerBorderVertex * clusters[c].borderVertices);
+                    worker.liveTriangles = faces.size();
+                    decimateRegion(faces, share, worker);
+                    removed[i] += faces.size() - worker.liveTriangles;
+                }
+            });
+        }
+        for (auto& t : pool) t.join();
+
+        for (unsigned i = 0; i < threads; ++i) {
+            live -= removed[i];
+            maxCost = std::max(maxCost, workers[i].maxCost);
+        }
+        for (auto& l : lock_) l &= ~kLockCluster;
+    }
+
+    // Serial pass over everything that is left, cluster borders included
+    if (live > target) {
+        std::vector<uint32_t> faces;
+        faces.reserve(live);
+        for (uint32_t f = 0; f < faceAlive_.size(); ++f) {
+            if (faceAlive_[f]) faces.push_back(f);
+        }
+        Worker worker;
+        worker.liveTriangles = live;
+        decimateRegion(faces, target, worker);
+        maxCost = std::max(maxCost, worker.maxCost);
+    }
+
+    compact();
+    stats.trianglesAfter = mesh_.triangleCount();
+    stats.verticesAfter = mesh_.vertexCount();
+    stats.maxError = std::sqrt(maxCost);
+    return stats;
+}
+
+} // namespace
+
+DecimateStats decimate(Mesh& mesh, const DecimateOptions& options) {
+    Decimator decimator(mesh, options);
+    return decimator.run();
+}
+
+} // namespace mcguire
@@ -0,0 +1,221 @@
+// src/mesh_json.cpp
+#include "mesh_json.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+
+namespace mcguire {
+
+namespace {
+
+constexpr size_t kSpillThreshold = 1 << 16;
+
+void appendDouble(std::string& buf, double v) {
+    if (!std::isfinite(v)) {
+        buf += "null";
+        return;
+    }
+    char tmp[32];
+#if defined(__cpp_lib_to_chars)
+    auto result = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    buf.append(tmp, result.ptr);
+#else
+    int n = std::snprintf(tmp, sizeof(tmp), "%.17g", v);
+    buf.append(tmp, n);
+#endif
+}
+
+void appendInteger(std::string& buf, long long v) {
+    char tmp[24];
+    auto result = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    buf.append(tmp, result.ptr);
+}
+
+void appendEscaped(std::string& buf, std::string_view s) {
+    static const char* hex = "0123456789abcdef";
+    buf += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  buf += "\\\""; break;
+            case '\\': buf += "\\\\"; break;
+            case '\n': buf += "\\n"; break;
+            case '\r': buf += "\\r"; break;
+            case '\t': buf += "\\t"; break;
+            case '\b': buf += "\\b"; break;
+            case '\f': buf += "\\f"; break;
+            default:
+                if (c < 0x20) {
+                    buf += "\\u00";
+                    buf += hex[c >> 4];
+                    buf += hex[c & 0xF];
+                } else {
+                    buf += static_cast<char>(c);
+                }
+        }
+    }
+    buf += '"';
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(std::ostream& out) : out_(out) {
+    buf_.reserve(kSpillThreshold * 2);
+}
+
+JsonWriter::~JsonWriter() {
+    if (!buf_.empty()) {
+        out_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+    }
+}
+
+void JsonWriter::separator() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (!first_.empty()) {
+        if (!first_.back()) buf_ += ',';
+        first_.back() = false;
+    }
+}
+
+void JsonWriter::open(char c) {
+    separator();
+    buf_ += c;
+    first_.push_back(true);
+}
+
+void JsonWriter::close(char c) {
+    buf_ += c;
+    first_.pop_back();
+    spill();
+}
+
+void JsonWriter::spill() {
+    if (buf_.size() >= kSpillThreshold) {
+        out_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+        buf_.clear();
+    }
+}
+
+void JsonWriter::beginObject() { open('{'); }
+void JsonWriter::endObject() { close('}'); }
+void JsonWriter::beginArray() { open('['); }
+void JsonWriter::endArray() { close(']'); }
+
+void JsonWriter::key(std::string_view name) {
+    separator();
+    appendEscaped(buf_, name);
+    buf_ += ':';
+    afterKey_ = true;
+}
+
+void JsonWriter::number(double v) {
+    separator();
+    appendDouble(buf_, v);
+}
+
+void JsonWriter::integer(long long v) {
+    separator();
+    appendInteger(buf_, v);
+}
+
+void JsonWriter::string(std::string_view v) {
+    separator();
+    appendEscaped(buf_, v);
+}
+
+void JsonWriter::boolean(bool v) {
+    separator();
+    buf_ += v ? "true" : "false";
+}
+
+void JsonWriter::null() {
+    separator();
+    buf_ += "null";
+}
+
+void JsonWriter::flush() {
+    out_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+    buf_.clear();
+    out_.flush();
+}
+
+void writeMeshFields(JsonWriter& w, const Mesh& mesh) {
+    w.key("vertices");
+    w.beginArray();
+    for (size_t v = 0; v < mesh.vertexCount(); ++v) {
+        w.beginArray();
+        w.number(mesh.x[v]);
+        w.number(mesh.y[v]);
+        w.number(mesh.z[v]);
+        w.endArray();
+    }
+    w.endArray();
+
+    w.key("faces");
+    w.beginArray();
+    for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+        w.beginArray();
+        w.integer(mesh.indices[t]);
+        w.integer(mesh.indices[t + 1]);
+        w.integer(mesh.indices[t + 2]);
+        w.endArray();
+    }
+    w.endArray();
+}
+
+void writeMeshCollection(JsonWriter& w, const MeshArena& meshes, size_t begin, size_t end,
+                         const std::string& defaultName) {
+    if (end - begin == 1) {
+        // Single mesh - maintain backward compatibility
+        const Mesh& mesh = meshes[begin];
+        if (!mesh.name.empty() && mesh.name != defaultName) {
+            w.key("name");
+            w.string(mesh.name);
+        }
+        writeMeshFields(w, mesh);
+        return;
+    }
+
+    // Multiple meshes - multi-body format
+    w.key("meshes");
+    w.beginArray();
+    for (size_t i = begin; i < end; ++i) {
+        w.beginObject();
+        w.key("name");
+        w.string(meshes[i].name);
+        writeMeshFields(w, meshes[i]);
+        w.endObject();
+    }
+    w.endArray();
+    w.key("mesh_count");
+    w.integer(static_cast<long long>(end - begin));
+}
+
+void writeMeshCollection(JsonWriter& w, const MeshArena& meshes, const std::string& defaultName) {
+    writeMeshCollection(w, meshes, 0, meshes.size(), defaultName);
+}
+
+void writeMeshDocument(const std::string& outputPath, const MeshArena& meshes,
+                       const MeshDocumentOptions& options) {
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) throw std::runtime_error("Failed to open output file for writing");
+
+    JsonWriter w(out);
+    w.beginObject();
+    writeMeshCollection(w, meshes, options.defaultName);
+    for (const auto& [name, value] : options.metadata) {
+        w.key(name);
+        w.number(value);
+    }
+    w.endObject();
+    w.flush();
+
+    if (!out) throw std::runtime_error("Failed to write output file");
+}
+
+} // namespace mcguire
@@ -0,0 +1,180 @@
+// src/mesh_sink.cpp
+#include "mesh_sink.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace mcguire {
+
+Mesh& MeshSink::acquire(const std::string& name) {
+    return meshes_.acquire(name);
+}
+
+void MeshSink::commit(bool keepEmpty) {
+    Mesh& mesh = meshes_.back();
+    if (mesh.isEmpty() && !keepEmpty) {
+        meshes_.discardLast();
+        return;
+    }
+    if (filter_ && !mesh.isEmpty()) filter_(mesh);
+    ++meshCount_;
+    vertexCount_ += mesh.vertexCount();
+    triangleCount_ += mesh.triangleCount();
+    if (!levels_.empty()) {
+        MeshLevel& level = levels_.back();
+        ++level.meshCount;
+        level.vertexCount += mesh.vertexCount();
+        level.triangleCount += mesh.triangleCount();
+    }
+    if (!onCommit(mesh)) {
+        meshes_.discardLast();
+    }
+}
+
+void MeshSink::beginLevel(MeshMetadata metadata) {
+    levels_.emplace_back();
+    levels_.back().metadata = std::move(metadata);
+    onBeginLevel(levels_.back());
+}
+
+namespace {
+
+void writeMetadata(JsonWriter& w, const MeshMetadata& metadata) {
+    for (const auto& [name, value] : metadata) {
+        w.key(name);
+        w.number(value);
+    }
+}
+
+void writeLevelCounts(JsonWriter& w, const MeshLevel& level) {
+    writeMetadata(w, level.metadata);
+    w.key("vertex_count");
+    w.integer(static_cast<long long>(level.vertexCount));
+    w.key("triangle_count");
+    w.integer(static_cast<long long>(level.triangleCount));
+}
+
+} // namespace
+
+DocumentSink::DocumentSink(const std::string& outputPath, MeshArena& meshes, std::string defaultName)
+    : MeshSink(meshes), outputPath_(outputPath), defaultName_(std::move(defaultName)) {}
+
+bool DocumentSink::onCommit(Mesh&) {
+    return true;
+}
+
+void DocumentSink::onBeginLevel(const MeshLevel&) {
+    levelStarts_.push_back(meshes_.size());
+}
+
+void DocumentSink::finish(const MeshMetadata& metadata) {
+    if (levels().empty()) {
+        MeshDocumentOptions options;
+        options.defaultName = defaultName_;
+        options.metadata = metadata;
+        writeMeshDocument(outputPath_, meshes_, options);
+        return;
+    }
+
+    std::ofstream out(outputPath_, std::ios::binary);
+    if (!out) throw std::runtime_error("Failed to open output file for writing");
+
+    JsonWriter w(out);
+    w.beginObject();
+    w.key("lod");
+    w.beginArray();
+    for (size_t i = 0; i < levels().size(); ++i) {
+        size_t end = i + 1 < levelStarts_.size() ? levelStarts_[i + 1] : meshes_.size();
+        w.beginObject();
+        writeLevelCounts(w, levels()[i]);
+        writeMeshCollection(w, meshes_, levelStarts_[i], end, defaultName_);
+        w.endObject();
+    }
+    w.endArray();
+    w.key("level_count");
+    w.integer(static_cast<long long>(levels().size()));
+    writeMetadata(w, metadata);
+    w.endObject();
+    w.flush();
+
+    if (!out) throw std::runtime_error("Failed to write output file");
+}
+
+NdjsonSink::NdjsonSink(const std::string& outputPath, MeshArena& meshes)
+    : MeshSink(meshes), out_(&std::cout) {
+    if (outputPath != "-") {
+        file_.open(outputPath, std::ios::binary);
+        if (!file_) throw std::runtime_error("Failed to open output file for writing");
+        out_ = &file_;
+    }
+    writer_ = std::make_unique<JsonWriter>(*out_);
+}
+
+NdjsonSink::~NdjsonSink() = default;
+
+bool NdjsonSink::onCommit(Mesh& mesh) {
+    JsonWriter& w = *writer_;
+    w.beginObject();
+    w.key("type");
+    w.string("mesh");
+    w.key("index");
+    w.integer(static_cast<long long>(meshCount() - 1));
+    if (!levels().empty()) {
+        w.key("level");
+        w.integer(static_cast<long long>(levels().size() - 1));
+    }
+    w.key("name");
+    w.string(mesh.name);
+    writeMeshFields(w, mesh);
+    w.endObject();
+    endRecord();
+    return false;
+}
+
+void NdjsonSink::onBeginLevel(const MeshLevel& level) {
+    JsonWriter& w = *writer_;
+    w.beginObject();
+    w.key("type");
+    w.string("level");
+    w.key("level");
+    w.integer(static_cast<long long>(levels().size() - 1));
+    writeMetadata(w, level.metadata);
+    w.endObject();
+    endRecord();
+}
+
+// Each record goes out whole and immediately
+void NdjsonSink::endRecord() {
+    writer_->flush();
+    *out_ << '\n' << std::flush;
+    if (!*out_) throw std::runtime_error("Failed to write output stream");
+}
+
+void NdjsonSink::finish(const MeshMetadata& metadata) {
+    JsonWriter& w = *writer_;
+    w.beginObject();
+    w.key("type");
+    w.string("trailer");
+    w.key("mesh_count");
+    w.integer(static_cast<long long>(meshCount()));
+    w.key("vertex_count");
+    w.integer(static_cast<long long>(vertexCount()));
+    w.key("triangle_count");
+    w.integer(static_cast<long long>(triangleCount()));
+    if (!levels().empty()) {
+        w.key("levels");
+        w.beginArray();
+        for (const MeshLevel& level : levels()) {
+            w.beginObject();
+            writeLevelCounts(w, level);
+            w.key("mesh_count");
+            w.integer(static_cast<long long>(level.meshCount));
+            w.endObject();
+        }
+        w.endArray();
+    }
+    writeMetadata(w, metadata);
+    w.endObject();
+    endRecord();
+}
+
+} // namespace mcguire
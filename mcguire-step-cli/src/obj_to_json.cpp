@@ -1,38 +1,18 @@
+#include "obj_to_json.h"
 #include <fstream>
 #include <sstream>
 #include <vector>
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <algorithm>
-#include <nlohmann/json.hpp>
-using json = nlohmann::json;
+#include <stdexcept>
 
-struct Mesh {
-    std::string name;
-    std::vector<std::vector<float>> vertices;
-    std::vector<std::vector<int>> faces;
-    std::map<int, int> globalToLocalVertexMap; // Maps global vertex index to local mesh index
-    
-    void addVertex(int globalIndex, const std::vector<float>& vertex) {
-        if (globalToLocalVertexMap.find(globalIndex) == globalToLocalVertexMap.end()) {
-            int localIndex = vertices.size();
-            globalToLocalVertexMap[globalIndex] = localIndex;
-            vertices.push_back(vertex);
-        }
-    }
-    
-    void addFace(const std::vector<int>& globalFace) {
-        std::vector<int> localFace;
-        for (int globalIdx : globalFace) {
-            localFace.push_back(globalToLocalVertexMap[globalIdx]);
-        }
-        faces.push_back(localFace);
-    }
-    
-    bool isEmpty() const {
-        return vertices.empty() && faces.empty();
-    }
-};
+#include "mesh.h"
+#include "mesh_sink.h"
+
+using mcguire::Mesh;
+using mcguire::MeshArena;
+using mcguire::MeshSink;
 
 std::vector<int> parseFaceIndices(const std::string& faceData) {
     std::vector<int> indices;
@@ -73,22 +53,21 @@ void triangulate(const std::vector<int>& face, std::vector<std::vector<int>>& tr
     }
 }
 
-void convertObjToJson(const std::string& inputPath, const std::string& outputPath) {
+void readObj(const std::string& inputPath, MeshSink& sink) {
     std::ifstream in(inputPath);
     if (!in.is_open()) throw std::runtime_error("Cannot open OBJ file");
     
-    std::vector<std::vector<float>> globalVertices;
-    std::vector<Mesh> meshes;
+    std::vector<float> globalVertices; // x, y, z per vertex
     std::string line;
     
-    Mesh* currentMesh = nullptr;
+    // Maps global vertex index to local mesh index; OBJ welds by index, not position
+    std::unordered_map<int, uint32_t> globalToLocal;
     std::string currentObjectName = "default";
     int meshIndex = 0;
     
     // Create initial default mesh
-    meshes.emplace_back();
-    meshes.back().name = currentObjectName;
-    currentMesh = &meshes.back();
+    Mesh* currentMesh = &sink.acquire(currentObjectName);
+    std::vector<std::vector<int>> triangles;
     
     while (std::getline(in, line)) {
         // Skip empty lines and comments
@@ -102,7 +81,9 @@ void convertObjToJson(const std::string& inputPath, const std::string& outputPat
             // Vertex definition
             float x, y, z;
             ss >> x >> y >> z;
-            globalVertices.push_back({x, y, z});
+            globalVertices.push_back(x);
+            globalVertices.push_back(y);
+            globalVertices.push_back(z);
             
         } else if (prefix == "o" || prefix == "g") {
             // Object or group definition - start new mesh
@@ -118,9 +99,10 @@ void convertObjToJson(const std::string& inputPath, const std::string& outputPat
             }
             
             // Only create new mesh if current one has data or if this is not the first object/group
-            if (!currentMesh->isEmpty() || meshes.size() > 1) {
-                meshes.emplace_back();
-                currentMesh = &meshes.back();
+            if (!currentMesh->isEmpty() || meshIndex > 0) {
+                sink.commit(); // empty meshes are dropped
+                currentMesh = &sink.acquire(std::string());
+                globalToLocal.clear();
                 meshIndex++;
             }
             
@@ -132,65 +114,55 @@ void convertObjToJson(const std::string& inputPath, const std::string& outputPat
             std::getline(ss, faceData);
             
             std::vector<int> faceIndices = parseFaceIndices(faceData);
+            if (faceIndices.size() < 3) continue;
             
-            if (faceIndices.size() >= 3) {
-                // Add vertices used by this face to current mesh
-                for (int globalIdx : faceIndices) {
-                    if (globalIdx >= 0 && globalIdx < static_cast<int>(globalVertices.size())) {
-                        currentMesh->addVertex(globalIdx, globalVertices[globalIdx]);
-                    }
+            const int globalCount = static_cast<int>(globalVertices.size() / 3);
+            bool valid = true;
+            for (int globalIdx : faceIndices) {
+                if (globalIdx < 0 || globalIdx >= globalCount) {
+                    valid = false;
+                    break;
                 }
-                
-                // Triangulate face if it has more than 3 vertices
-                std::vector<std::vector<int>> triangles;
-                triangulate(faceIndices, triangles);
-                
-                for (const auto& triangle : triangles) {
-                    currentMesh->addFace(triangle);
+            }
+            if (!valid) continue;
+            
+            // Add vertices used by this face to current mesh
+            for (int& globalIdx : faceIndices) {
+                auto [it, inserted] = globalToLocal.emplace(globalIdx, 0);
+                if (inserted) {
+                    const float* p = &globalVertices[static_cast<size_t>(globalIdx) * 3];
+                    it->second = currentMesh->addVertex(p[0], p[1], p[2]);
                 }
+                globalIdx = static_cast<int>(it->second);
+            }
+            
+            // Triangulate face if it has more than 3 vertices
+            triangles.clear();
+            triangulate(faceIndices, triangles);
+            
+            for (const auto& triangle : triangles) {
+                currentMesh->addTriangle(triangle[0], triangle[1], triangle[2]);
             }
         }
         // Ignore other OBJ elements like materials (mtllib, usemtl), texture coords (vt), normals (vn), etc.
     }
     
-    // Remove empty meshes
-    meshes.erase(std::remove_if(meshes.begin(), meshes.end(), 
-                               [](const Mesh& mesh) { return mesh.isEmpty(); }), 
-                 meshes.end());
+    sink.commit();
     
-    if (meshes.empty()) {
+    if (sink.meshCount() == 0) {
         throw std::runtime_error("No valid geometry found in OBJ file");
     }
     
-    json j;
-    
-    // Check if we have multiple meshes
-    if (meshes.size() == 1) {
-        // Single mesh - maintain backward compatibility
-        j["vertices"] = meshes[0].vertices;
-        j["faces"] = meshes[0].faces;
-        
-        // Include mesh name if it's not the default
-        if (!meshes[0].name.empty() && meshes[0].name != "default") {
-            j["name"] = meshes[0].name;
-        }
-    } else {
-        // Multiple meshes - use new multi-body format
-        j["meshes"] = json::array();
-        
-        for (const auto& mesh : meshes) {
-            json meshJson;
-            meshJson["name"] = mesh.name;
-            meshJson["vertices"] = mesh.vertices;
-            meshJson["faces"] = mesh.faces;
-            
-            j["meshes"].push_back(meshJson);
-        }
-        
-        // Add metadata
-        j["mesh_count"] = meshes.size();
-    }
-    
-    std::ofstream out(outputPath);
-    out << j.dump(2);
-}
\ No newline at end of file
+    sink.finish({});
+}
+
+void convertObjToJson(const std::string& inputPath, const std::string& outputPath, MeshArena& meshes) {
+    meshes.reset();
+    mcguire::DocumentSink sink(outputPath, meshes, "default");
+    readObj(inputPath, sink);
+}
+
+void convertObjToJson(const std::string& inputPath, const std::string& outputPath) {
+    MeshArena meshes;
+    convertObjToJson(inputPath, outputPath, meshes);
+}
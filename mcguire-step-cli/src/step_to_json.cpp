@@ -4,8 +4,6 @@
 #include <BRepMesh_IncrementalMesh.hxx>
 #include <TopExp_Explorer.hxx>
 #include <TopoDS_Face.hxx>
-#include <TopoDS_Solid.hxx>
-#include <TopoDS_Compound.hxx>
 #include <BRep_Tool.hxx>
 #include <Poly_Triangulation.hxx>
 #include <TopoDS.hxx>
@@ -19,65 +17,95 @@
 #include <STEPCAFControl_Reader.hxx>
 #include <TDF_LabelSequence.hxx>
 #include <TCollection_ExtendedString.hxx>
-#include <nlohmann/json.hpp>
+#include <TDocStd_Document.hxx>
+#include <TopoDS_Edge.hxx>
+#include <TopoDS_Compound.hxx>
+#include <BRep_Builder.hxx>
+#include <BRepTools.hxx>
+#include <BRepAdaptor_Curve.hxx>
+#include <BRepAdaptor_Surface.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepGProp.hxx>
+#include <Bnd_Box.hxx>
+#include <GCPnts_AbscissaPoint.hxx>
+#include <GProp_GProps.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <Message.hxx>
+#include <Message_Messenger.hxx>
+#include <Message_PrinterOStream.hxx>
+#include <iostream>
 #include <fstream>
-#include <map>
 #include <vector>
 #include <string>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
 
-using json = nlohmann::json;
+#include "mesh.h"
+#include "mesh_json.h"
+#include "mesh_sink.h"
 
-struct PointComparator {
-    bool operator()(const gp_Pnt& a, const gp_Pnt& b) const {
-        const double tolerance = 1e-9;
-        if (std::abs(a.X() - b.X()) > tolerance) return a.X() < b.X();
-        if (std::abs(a.Y() - b.Y()) > tolerance) return a.Y() < b.Y();
-        return a.Z() < b.Z() - tolerance;
-    }
-};
+using mcguire::Mesh;
+using mcguire::MeshArena;
+using mcguire::MeshSink;
+using mcguire::VertexWelder;
+
+namespace {
+
+// Face triangulations of neighbouring faces share their edge nodes up to
+// round-off; merge anything closer than this.
+constexpr double kWeldTolerance = 1e-9;
 
-struct Mesh {
+// A meshable unit of the model. Bodies are numbered in the order they are
+// collected; manifest indices and body selectors refer to that order.
+struct StepBody {
     std::string name;
-    std::vector<std::array<double, 3>> vertices;
-    std::vector<std::array<int, 3>> faces;
-    std::map<gp_Pnt, int, PointComparator> vertexMap;
-    
-    void addVertex(const gp_Pnt& pt) {
-        if (vertexMap.find(pt) == vertexMap.end()) {
-            int id = vertices.size();
-            vertexMap[pt] = id;
-            vertices.push_back({pt.X(), pt.Y(), pt.Z()});
-        }
-    }
-    
-    void addFace(const gp_Pnt& p1, const gp_Pnt& p2, const gp_Pnt& p3) {
-        addVertex(p1);
-        addVertex(p2);
-        addVertex(p3);
-        faces.push_back({vertexMap[p1], vertexMap[p2], vertexMap[p3]});
-    }
-    
-    bool isEmpty() const {
-        return vertices.empty() && faces.empty();
-    }
+    TopoDS_Shape shape;
 };
 
-std::string getShapeName(const TDF_Label& label, int defaultIndex) {
+struct StepModel {
+    Handle(TDocStd_Document) doc;        // null when read with the basic reader
+    Handle(XCAFDoc_ShapeTool) shapeTool; // null when read with the basic reader
+    std::vector<StepBody> bodies;
+};
+
+bool findShapeName(const TDF_Label& label, std::string& name) {
     Handle(TDataStd_Name) nameAttr;
     if (label.FindAttribute(TDataStd_Name::GetID(), nameAttr)) {
         TCollection_ExtendedString extName = nameAttr->Get();
         TCollection_AsciiString asciiName(extName);
         Standard_CString cstr = asciiName.ToCString();
         if (cstr && strlen(cstr) > 0) {
-            return std::string(cstr);
+            name = cstr;
+            return true;
         }
     }
+    return false;
+}
+
+std::string getShapeName(const TDF_Label& label, int defaultIndex) {
+    std::string name;
+    if (findShapeName(label, name)) {
+        return name;
+    }
     return "body_" + std::to_string(defaultIndex);
 }
 
-void meshShape(const TopoDS_Shape& shape, Mesh& mesh, double deflection = 0.1) {
-    // Create mesh for the shape
-    BRepMesh_IncrementalMesh mesher(shape, deflection);
+int countSolids(const TopoDS_Shape& shape) {
+    int solidCount = 0;
+    for (TopExp_Explorer exp(shape, TopAbs_SOLID); exp.More(); exp.Next()) {
+        solidCount++;
+    }
+    return solidCount;
+}
+
+// Appends the existing face triangulations of shape to mesh, welded.
+void extractTriangulation(const TopoDS_Shape& shape, Mesh& mesh) {
+    VertexWelder welder(kWeldTolerance);
+    welder.begin(mesh);
+    std::vector<uint32_t> localToMesh;
     
     // Extract triangulation from all faces
     for (TopExp_Explorer exp(shape, TopAbs_FACE); exp.More(); exp.Next()) {
@@ -90,217 +118,490 @@ void meshShape(const TopoDS_Shape& shape, Mesh& mesh, double deflection = 0.1) {
         int nbNodes = triangulation->NbNodes();
         int nbTriangles = triangulation->NbTriangles();
         
-        // Create mapping from local triangle indices to global vertices
-        std::vector<gp_Pnt> localVertices(nbNodes + 1); // OCC is 1-based
+        // Weld each node once; OCC is 1-based
+        const gp_Trsf& trsf = loc.Transformation();
+        localToMesh.assign(nbNodes + 1, 0);
         for (int i = 1; i <= nbNodes; ++i) {
-            localVertices[i] = triangulation->Node(i).Transformed(loc.Transformation());
+            gp_Pnt p = triangulation->Node(i).Transformed(trsf);
+            localToMesh[i] = welder.weld(p.X(), p.Y(), p.Z());
         }
         
         // Add triangles
+        const bool reversed = face.Orientation() == TopAbs_REVERSED;
         for (int i = 1; i <= nbTriangles; ++i) {
             Poly_Triangle t = triangulation->Triangle(i);
             int n1, n2, n3;
             t.Get(n1, n2, n3);
             
             // Handle face orientation
-            if (face.Orientation() == TopAbs_REVERSED) {
-                mesh.addFace(localVertices[n1], localVertices[n3], localVertices[n2]);
+            if (reversed) {
+                mesh.addTriangle(localToMesh[n1], localToMesh[n3], localToMesh[n2]);
             } else {
-                mesh.addFace(localVertices[n1], localVertices[n2], localVertices[n3]);
+                mesh.addTriangle(localToMesh[n1], localToMesh[n2], localToMesh[n3]);
             }
         }
     }
 }
 
-std::vector<Mesh> extractMeshesWithCAF(const std::string& inputPath, double deflection = 0.1) {
-    std::vector<Mesh> meshes;
-    
+// Lists the bodies of the model without meshing anything. Multiple free
+// shapes become one body each; a single free shape is split into its solids
+// when it has more than one.
+void collectBodiesWithCAF(const std::string& inputPath, StepModel& model) {
     // Try to read with CAF (Component Application Framework) for better component separation
     Handle(XCAFApp_Application) app = XCAFApp_Application::GetApplication();
-    Handle(TDocStd_Document) doc;
-    app->NewDocument("MDTV-XCAF", doc);
-    
+    app->NewDocument("MDTV-XCAF", model.doc);
+
     STEPCAFControl_Reader reader;
     if (reader.ReadFile(inputPath.c_str()) != IFSelect_RetDone) {
         throw std::runtime_error("Failed to read STEP file with CAF reader");
     }
-    
-    if (!reader.Transfer(doc)) {
+
+    if (!reader.Transfer(model.doc)) {
         throw std::runtime_error("Failed to transfer STEP data");
     }
-    
-    Handle(XCAFDoc_ShapeTool) shapeTool = XCAFDoc_DocumentTool::ShapeTool(doc->Main());
+
+    model.shapeTool = XCAFDoc_DocumentTool::ShapeTool(model.doc->Main());
     TDF_LabelSequence topLevelShapes;
-    shapeTool->GetFreeShapes(topLevelShapes);
-    
+    model.shapeTool->GetFreeShapes(topLevelShapes);
+
     // If we have multiple top-level shapes, treat each as a separate mesh
     if (topLevelShapes.Length() > 1) {
         for (int i = 1; i <= topLevelShapes.Length(); ++i) {
             TDF_Label label = topLevelShapes.Value(i);
             TopoDS_Shape shape;
-            if (shapeTool->GetShape(label, shape)) {
-                Mesh mesh;
-                mesh.name = getShapeName(label, i - 1);
-                meshShape(shape, mesh, deflection);
-                if (!mesh.isEmpty()) {
-                    meshes.push_back(std::move(mesh));
-                }
+            if (model.shapeTool->GetShape(label, shape)) {
+                model.bodies.push_back({getShapeName(label, i - 1), shape});
             }
         }
     } else if (topLevelShapes.Length() == 1) {
         // Single top-level shape - check if it contains multiple solids
         TDF_Label rootLabel = topLevelShapes.Value(1);
         TopoDS_Shape rootShape;
-        shapeTool->GetShape(rootLabel, rootShape);
-        
-        // Count solids in the root shape
-        int solidCount = 0;
-        for (TopExp_Explorer exp(rootShape, TopAbs_SOLID); exp.More(); exp.Next()) {
-            solidCount++;
-        }
-        
-        if (solidCount > 1) {
+        model.shapeTool->GetShape(rootLabel, rootShape);
+
+        if (countSolids(rootShape) > 1) {
             // Multiple solids - create separate mesh for each
             int solidIndex = 0;
             for (TopExp_Explorer exp(rootShape, TopAbs_SOLID); exp.More(); exp.Next()) {
-                TopoDS_Solid solid = TopoDS::Solid(exp.Current());
-                Mesh mesh;
-                mesh.name = "solid_" + std::to_string(solidIndex);
-                meshShape(solid, mesh, deflection);
-                if (!mesh.isEmpty()) {
-                    meshes.push_back(std::move(mesh));
-                }
+                model.bodies.push_back({"solid_" + std::to_string(solidIndex), exp.Current()});
                 solidIndex++;
             }
         } else {
             // Single solid or no solids - treat as single mesh
-            Mesh mesh;
-            mesh.name = getShapeName(rootLabel, 0);
-            meshShape(rootShape, mesh, deflection);
-            if (!mesh.isEmpty()) {
-                meshes.push_back(std::move(mesh));
-            }
+            model.bodies.push_back({getShapeName(rootLabel, 0), rootShape});
         }
     }
-    
-    return meshes;
 }
 
-std::vector<Mesh> extractMeshesBasic(const std::string& inputPath, double deflection = 0.1) {
-    std::vector<Mesh> meshes;
-    
+void collectBodiesBasic(const std::string& inputPath, StepModel& model) {
     STEPControl_Reader reader;
     if (reader.ReadFile(inputPath.c_str()) != IFSelect_RetDone) {
         throw std::runtime_error("Failed to read STEP file");
     }
-    
+
     reader.TransferRoots();
     TopoDS_Shape shape = reader.OneShape();
-    
-    // Check if we have multiple solids
-    int solidCount = 0;
-    for (TopExp_Explorer exp(shape, TopAbs_SOLID); exp.More(); exp.Next()) {
-        solidCount++;
-    }
-    
-    if (solidCount > 1) {
+
+    if (countSolids(shape) > 1) {
         // Multiple solids - create separate mesh for each
         int solidIndex = 0;
         for (TopExp_Explorer exp(shape, TopAbs_SOLID); exp.More(); exp.Next()) {
-            TopoDS_Solid solid = TopoDS::Solid(exp.Current());
-            Mesh mesh;
-            mesh.name = "solid_" + std::to_string(solidIndex);
-            meshShape(solid, mesh, deflection);
-            if (!mesh.isEmpty()) {
-                meshes.push_back(std::move(mesh));
-            }
+            model.bodies.push_back({"solid_" + std::to_string(solidIndex), exp.Current()});
             solidIndex++;
         }
     } else {
         // Single solid or complex shape - treat as single mesh
-        Mesh mesh;
-        mesh.name = "shape_0";
-        meshShape(shape, mesh, deflection);
-        if (!mesh.isEmpty()) {
-            meshes.push_back(std::move(mesh));
-        }
+        model.bodies.push_back({"shape_0", shape});
     }
-    
-    return meshes;
 }
 
-void convertStepToJson(const std::string& inputPath, const std::string& outputPath, double deflection = 0.1) {
-    std::vector<Mesh> meshes;
-    
+StepModel readStepModel(const std::string& inputPath) {
+    StepModel model;
+
     // Try CAF reader first for better component separation
     try {
-        meshes = extractMeshesWithCAF(inputPath, deflection);
+        collectBodiesWithCAF(inputPath, model);
     } catch (const std::exception&) {
         // Fall back to basic reader
+        model = StepModel();
         try {
-            meshes = extractMeshesBasic(inputPath, deflection);
+            collectBodiesBasic(inputPath, model);
         } catch (const std::exception& e) {
             throw std::runtime_error("Failed to read STEP file with both CAF and basic readers: " + std::string(e.what()));
         }
     }
-    
-    if (meshes.empty()) {
-        throw std::runtime_error("No valid geometry found in STEP file");
+
+    return model;
+}
+
+// Resolves selectors (manifest indices or body names) to a mask over
+// model.bodies. An empty selector list selects everything.
+std::vector<bool> selectBodies(const StepModel& model, const std::vector<std::string>& selectors) {
+    std::vector<bool> selected(model.bodies.size(), selectors.empty());
+
+    for (const auto& selector : selectors) {
+        bool matched = false;
+        bool numeric = !selector.empty() &&
+            std::all_of(selector.begin(), selector.end(), [](unsigned char c) { return std::isdigit(c); });
+        if (numeric) {
+            size_t index = std::stoul(selector);
+            if (index < selected.size()) {
+                selected[index] = true;
+                matched = true;
+            }
+        }
+        for (size_t i = 0; i < model.bodies.size(); ++i) {
+            if (model.bodies[i].name == selector) {
+                selected[i] = true;
+                matched = true;
+            }
+        }
+        if (!matched) {
+            throw std::runtime_error("No body matches '" + selector + "'");
+        }
     }
-    
-    json j;
-    
-    // Check if we have multiple meshes
-    if (meshes.size() == 1) {
-        // Single mesh - maintain backward compatibility
-        j["vertices"] = json::array();
-        j["faces"] = json::array();
-        
-        for (const auto& v : meshes[0].vertices) {
-            j["vertices"].push_back({v[0], v[1], v[2]});
+
+    return selected;
+}
+
+// Length of a chord whose sagitta on the given radius equals the
+// deflection, capped by the mesher's default angular deflection (0.5 rad).
+double chordLength(double radius, double deflection) {
+    if (radius <= 0.0) return deflection;
+    double linear = deflection < radius ? std::sqrt(8.0 * radius * deflection) : radius;
+    return std::max(std::min(linear, 0.5 * radius), 1e-12);
+}
+
+double shapeRadius(const TopoDS_Shape& shape) {
+    Bnd_Box box;
+    BRepBndLib::Add(shape, box, false);
+    if (box.IsVoid()) return 0.0;
+    return 0.5 * std::sqrt(box.SquareExtent());
+}
+
+// Number of segments the mesher is expected to put on an edge.
+double estimateEdgeSegments(const TopoDS_Edge& edge, double deflection) {
+    if (BRep_Tool::Degenerated(edge)) return 0.0;
+    BRepAdaptor_Curve curve(edge);
+
+    double radius;
+    switch (curve.GetType()) {
+        case GeomAbs_Line:    return 1.0;
+        case GeomAbs_Circle:  radius = curve.Circle().Radius(); break;
+        case GeomAbs_Ellipse: radius = curve.Ellipse().MinorRadius(); break;
+        default:              radius = shapeRadius(edge); break;
+    }
+    double length = GCPnts_AbscissaPoint::Length(curve);
+    return std::max(1.0, std::ceil(length / chordLength(radius, deflection)));
+}
+
+// Rough triangle count for meshing shape at deflection, from geometry alone.
+// Planar and singly curved faces are triangulated from their boundary
+// nodes; doubly curved faces also get interior nodes proportional to area.
+double estimateTriangles(const TopoDS_Shape& shape, double deflection) {
+    double total = 0.0;
+
+    for (TopExp_Explorer exp(shape, TopAbs_FACE); exp.More(); exp.Next()) {
+        TopoDS_Face face = TopoDS::Face(exp.Current());
+
+        double boundaryNodes = 0.0;
+        for (TopExp_Explorer edges(face, TopAbs_EDGE); edges.More(); edges.Next()) {
+            boundaryNodes += estimateEdgeSegments(TopoDS::Edge(edges.Current()), deflection);
         }
-        
-        for (const auto& f : meshes[0].faces) {
-            j["faces"].push_back({f[0], f[1], f[2]});
+
+        BRepAdaptor_Surface surface(face, false);
+        double radius;
+        switch (surface.GetType()) {
+            case GeomAbs_Plane:
+            case GeomAbs_Cylinder:
+            case GeomAbs_Cone:
+            case GeomAbs_SurfaceOfExtrusion:
+                total += std::max(1.0, boundaryNodes - 2.0);
+                continue;
+            case GeomAbs_Sphere: radius = surface.Sphere().Radius(); break;
+            case GeomAbs_Torus:  radius = surface.Torus().MinorRadius(); break;
+            default:             radius = shapeRadius(face); break;
         }
-        
-        // Include mesh name if meaningful
-        if (!meshes[0].name.empty() && meshes[0].name != "shape_0") {
-            j["name"] = meshes[0].name;
+
+        GProp_GProps props;
+        BRepGProp::SurfaceProperties(face, props);
+        double chord = chordLength(radius, deflection);
+        double interior = props.Mass() / (chord * chord * std::sqrt(3.0) / 4.0);
+        total += std::max(1.0, interior + boundaryNodes - 2.0);
+    }
+
+    return total;
+}
+
+void writeBoundingBox(mcguire::JsonWriter& w, const TopoDS_Shape& shape) {
+    Bnd_Box box;
+    BRepBndLib::Add(shape, box, false);
+    w.key("bounding_box");
+    if (box.IsVoid()) {
+        w.null();
+        return;
+    }
+    double xmin, ymin, zmin, xmax, ymax, zmax;
+    box.Get(xmin, ymin, zmin, xmax, ymax, zmax);
+    w.beginObject();
+    w.key("min");
+    w.beginArray();
+    w.number(xmin);
+    w.number(ymin);
+    w.number(zmin);
+    w.endArray();
+    w.key("max");
+    w.beginArray();
+    w.number(xmax);
+    w.number(ymax);
+    w.number(zmax);
+    w.endArray();
+    w.endObject();
+}
+
+// Maps the shapes of model.bodies, and the solids inside them, to body
+// indices so that assembly nodes can be linked to the bodies they cover.
+struct BodyIndex {
+    TopTools_IndexedMapOfShape shapes;
+    std::vector<size_t> body; // body[i - 1] owns shapes(i)
+};
+
+BodyIndex indexBodies(const StepModel& model) {
+    BodyIndex index;
+    auto add = [&](const TopoDS_Shape& shape, size_t i) {
+        if (index.shapes.Add(shape) > static_cast<int>(index.body.size())) index.body.push_back(i);
+    };
+    for (size_t i = 0; i < model.bodies.size(); ++i) {
+        add(model.bodies[i].shape, i);
+        for (TopExp_Explorer exp(model.bodies[i].shape, TopAbs_SOLID); exp.More(); exp.Next()) {
+            add(exp.Current(), i);
         }
-    } else {
-        // Multiple meshes - use new multi-body format
-        j["meshes"] = json::array();
-        
-        for (const auto& mesh : meshes) {
-            json meshJson;
-            meshJson["name"] = mesh.name;
-            meshJson["vertices"] = json::array();
-            meshJson["faces"] = json::array();
-            
-            for (const auto& v : mesh.vertices) {
-                meshJson["vertices"].push_back({v[0], v[1], v[2]});
-            }
-            
-            for (const auto& f : mesh.faces) {
-                meshJson["faces"].push_back({f[0], f[1], f[2]});
-            }
-            
-            j["meshes"].push_back(meshJson);
+    }
+    return index;
+}
+
+// Indices of the bodies that make up shape, which must be placed in model
+// coordinates: the body it is, or the bodies owning its solids.
+std::vector<size_t> bodiesOf(const BodyIndex& index, const TopoDS_Shape& shape) {
+    std::vector<size_t> bodies;
+    if (int found = index.shapes.FindIndex(shape)) {
+        bodies.push_back(index.body[found - 1]);
+        return bodies;
+    }
+    for (TopExp_Explorer exp(shape, TopAbs_SOLID); exp.More(); exp.Next()) {
+        if (int found = index.shapes.FindIndex(exp.Current())) {
+            bodies.push_back(index.body[found - 1]);
         }
-        
-        // Add metadata
-        j["mesh_count"] = meshes.size();
     }
-    
-    // Add processing metadata
-    j["deflection"] = deflection;
-    
-    std::ofstream out(outputPath);
-    out << j.dump(2);
+    std::sort(bodies.begin(), bodies.end());
+    bodies.erase(std::unique(bodies.begin(), bodies.end()), bodies.end());
+    return bodies;
+}
+
+// Writes one node of the XCAF assembly tree. Component (instance) labels
+// are named after the instance when it has a name, otherwise after the
+// part it refers to. "bodies" lists the manifest indices the node covers,
+// usable as a --bodies selector; parent is the placement of the enclosing
+// assembly in model coordinates.
+void writeAssemblyNode(mcguire::JsonWriter& w, const Handle(XCAFDoc_ShapeTool)& shapeTool,
+                       const BodyIndex& bodyIndex, const TDF_Label& label, int index,
+                       const TopLoc_Location& parent) {
+    TDF_Label definition = label;
+    TDF_Label referred;
+    if (XCAFDoc_ShapeTool::IsReference(label) && XCAFDoc_ShapeTool::GetReferredShape(label, referred)) {
+        definition = referred;
+    }
+
+    std::string name;
+    if (!findShapeName(label, name)) {
+        name = getShapeName(definition, index);
+    }
+    TopoDS_Shape shape;
+    shapeTool->GetShape(label, shape);
+    shape = shape.Moved(parent);
+
+    w.beginObject();
+    w.key("name");
+    w.string(name);
+    w.key("solid_count");
+    w.integer(countSolids(shape));
+    w.key("bodies");
+    w.beginArray();
+    for (size_t body : bodiesOf(bodyIndex, shape)) {
+        w.integer(static_cast<long long>(body));
+    }
+    w.endArray();
+    writeBoundingBox(w, shape);
+
+    if (XCAFDoc_ShapeTool::IsAssembly(definition)) {
+        TDF_LabelSequence components;
+        XCAFDoc_ShapeTool::GetComponents(definition, components, false);
+        w.key("children");
+        w.beginArray();
+        for (int i = 1; i <= components.Length(); ++i) {
+            writeAssemblyNode(w, shapeTool, bodyIndex, components.Value(i), i - 1, shape.Location());
+        }
+        w.endArray();
+    }
+    w.endObject();
+}
+
+void meshShape(const TopoDS_Shape& shape, Mesh& mesh, double deflection = 0.1) {
+    // Create mesh for the shape
+    BRepMesh_IncrementalMesh mesher(shape, deflection);
+    extractTriangulation(shape, mesh);
+}
+
+// Meshes the selected bodies once per level, coarse to fine, from the one
+// parsed model. Each level meshes all selected bodies together so that
+// edges shared between bodies get the same discretization and weld cleanly.
+void meshLevels(const StepModel& model, const std::vector<bool>& selected,
+                std::vector<StepLodLevel> levels, MeshSink& sink) {
+    std::stable_sort(levels.begin(), levels.end(), [](const StepLodLevel& a, const StepLodLevel& b) {
+        return a.linearDeflection > b.linearDeflection;
+    });
+
+    TopoDS_Compound compound;
+    BRep_Builder builder;
+    builder.MakeCompound(compound);
+    for (size_t i = 0; i < model.bodies.size(); ++i) {
+        if (selected[i]) builder.Add(compound, model.bodies[i].shape);
+    }
+
+    for (const StepLodLevel& level : levels) {
+        // Drop the previous level's triangulation so this one is built from
+        // scratch at its own deflections
+        BRepTools::Clean(compound);
+        BRepMesh_IncrementalMesh mesher(compound, level.linearDeflection, Standard_False,
+                                        level.angularDeflection, Standard_True);
+
+        sink.beginLevel({{"linear_deflection", level.linearDeflection},
+                         {"angular_deflection", level.angularDeflection}});
+        for (size_t i = 0; i < model.bodies.size(); ++i) {
+            if (!selected[i]) continue;
+            Mesh& mesh = sink.acquire(model.bodies[i].name);
+            extractTriangulation(model.bodies[i].shape, mesh);
+            sink.commit();
+        }
+    }
+}
+
+} // namespace
+
+void meshStep(const std::string& inputPath, const StepConvertOptions& options, MeshSink& sink) {
+    StepModel model = readStepModel(inputPath);
+    std::vector<bool> selected = selectBodies(model, options.bodies);
+
+    if (!options.lods.empty()) {
+        meshLevels(model, selected, options.lods, sink);
+        if (sink.meshCount() == 0) {
+            throw std::runtime_error("No valid geometry found in STEP file");
+        }
+        sink.finish({});
+        return;
+    }
+
+    // Each body is handed over as soon as it is meshed and welded
+    for (size_t i = 0; i < model.bodies.size(); ++i) {
+        if (!selected[i]) continue;
+        Mesh& mesh = sink.acquire(model.bodies[i].name);
+        meshShape(model.bodies[i].shape, mesh, options.deflection);
+        sink.commit();
+    }
+
+    if (sink.meshCount() == 0) {
+        throw std::runtime_error("No valid geometry found in STEP file");
+    }
+
+    sink.finish({{"deflection", options.deflection}}); // processing metadata
+}
+
+void convertStepToJson(const std::string& inputPath, const std::string& outputPath,
+                       MeshArena& meshes, const StepConvertOptions& options) {
+    meshes.reset();
+    mcguire::DocumentSink sink(outputPath, meshes, "shape_0");
+    meshStep(inputPath, options, sink);
+}
+
+void convertStepToJson(const std::string& inputPath, const std::string& outputPath,
+                       const StepConvertOptions& options) {
+    MeshArena meshes;
+    convertStepToJson(inputPath, outputPath, meshes, options);
+}
+
+void convertStepToJson(const std::string& inputPath, const std::string& outputPath, double deflection) {
+    StepConvertOptions options;
+    options.deflection = deflection;
+    convertStepToJson(inputPath, outputPath, options);
 }
 
 // Overloaded version to maintain backward compatibility
 void convertStepToJson(const std::string& inputPath, const std::string& outputPath) {
     convertStepToJson(inputPath, outputPath, 0.1);
-}
\ No newline at end of file
+}
+
+void sendStepMessagesToStderr() {
+    Message_SequenceOfPrinters& printers = Message::DefaultMessenger()->ChangePrinters();
+    for (int i = 1; i <= printers.Length(); ++i) {
+        Handle(Message_PrinterOStream) printer = Handle(Message_PrinterOStream)::DownCast(printers.Value(i));
+        if (printer.IsNull() || &printer->GetStream() != &std::cout) continue;
+        printers.SetValue(i, new Message_PrinterOStream("cerr", Standard_False, printer->GetTraceLevel()));
+    }
+}
+
+void writeStepManifest(const std::string& inputPath, const std::string& outputPath, double deflection) {
+    StepModel model = readStepModel(inputPath);
+
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) throw std::runtime_error("Failed to open output file for writing");
+
+    mcguire::JsonWriter w(out);
+    w.beginObject();
+
+    double totalTriangles = 0.0;
+    w.key("bodies");
+    w.beginArray();
+    for (size_t i = 0; i < model.bodies.size(); ++i) {
+        const StepBody& body = model.bodies[i];
+        double triangles = estimateTriangles(body.shape, deflection);
+        totalTriangles += triangles;
+
+        w.beginObject();
+        w.key("index");
+        w.integer(static_cast<long long>(i));
+        w.key("name");
+        w.string(body.name);
+        w.key("solid_count");
+        w.integer(countSolids(body.shape));
+        writeBoundingBox(w, body.shape);
+        w.key("estimated_triangles");
+        w.integer(std::llround(triangles));
+        w.endObject();
+    }
+    w.endArray();
+    w.key("body_count");
+    w.integer(static_cast<long long>(model.bodies.size()));
+    w.key("estimated_triangles");
+    w.integer(std::llround(totalTriangles));
+
+    // Assembly structure as authored, for building a parts tree
+    if (!model.shapeTool.IsNull()) {
+        TDF_LabelSequence topLevelShapes;
+        model.shapeTool->GetFreeShapes(topLevelShapes);
+        BodyIndex bodyIndex = indexBodies(model);
+        w.key("assembly");
+        w.beginArray();
+        for (int i = 1; i <= topLevelShapes.Length(); ++i) {
+            writeAssemblyNode(w, model.shapeTool, bodyIndex, topLevelShapes.Value(i), i - 1,
+                              TopLoc_Location());
+        }
+        w.endArray();
+    }
+
+    w.key("deflection");
+    w.number(deflection);
+    w.endObject();
+    w.flush();
+
+    if (!out) throw std::runtime_error("Failed to write output file");
+}
@@ -4,41 +4,29 @@
 #include <iostream>
 #include <vector>
 #include <array>
-#include <map>
-#include <nlohmann/json.hpp>
-using json = nlohmann::json;
-
-struct Vec3 {
-    float x, y, z;
-    bool operator<(const Vec3& other) const {
-        return std::tie(x, y, z) < std::tie(other.x, other.y, other.z);
-    }
-};
-
-struct Mesh {
-    std::string name;
-    std::vector<Vec3> vertices;
-    std::vector<std::array<int, 3>> faces;
-    std::map<Vec3, int> vertexMap;
-    
-    void addVertex(const Vec3& v, std::array<int, 3>& currentFace, int faceVertexIndex) {
-        auto [it, inserted] = vertexMap.emplace(v, vertices.size());
-        if (inserted) {
-            vertices.push_back(v);
-        }
-        currentFace[faceVertexIndex] = vertexMap[v];
-    }
-    
-    void addFace(const std::array<int, 3>& face) {
-        faces.push_back(face);
-    }
-    
-    void clear() {
-        vertices.clear();
-        faces.clear();
-        vertexMap.clear();
-    }
-};
+#include <cstring>
+#include <algorithm>
+
+#include "mesh.h"
+#include "mesh_sink.h"
+
+using mcguire::Mesh;
+using mcguire::MeshArena;
+using mcguire::MeshSink;
+using mcguire::VertexWelder;
+
+namespace {
+
+constexpr size_t kBinaryTriangleSize = 50; // normal, 3 vertices, attribute count
+constexpr size_t kBinaryChunkTriangles = 1 << 14;
+
+float readFloat(const char* p) {
+    float f;
+    std::memcpy(&f, p, sizeof(f));
+    return f;
+}
+
+} // namespace
 
 bool isAsciiStl(const std::string& path) {
     std::ifstream in(path);
@@ -47,26 +35,24 @@ bool isAsciiStl(const std::string& path) {
     return line.find("solid") != std::string::npos;
 }
 
-std::vector<Mesh> parseAsciiStl(std::ifstream& in) {
-    std::vector<Mesh> meshes;
+void parseAsciiStl(std::ifstream& in, MeshSink& sink) {
     std::string line;
-    Mesh currentMesh;
-    std::array<int, 3> currentFace;
+    Mesh* currentMesh = nullptr;
+    VertexWelder welder;
+    std::array<uint32_t, 3> currentFace{};
     int vertexCount = 0;
-    bool inSolid = false;
-    
+
     while (std::getline(in, line)) {
         std::istringstream iss(line);
         std::string keyword;
         iss >> keyword;
-        
+
         if (keyword == "solid") {
-            if (inSolid && (!currentMesh.vertices.empty() || !currentMesh.faces.empty())) {
-                // Save previous mesh if it has data
-                meshes.push_back(std::move(currentMesh));
-                currentMesh.clear();
+            if (currentMesh) {
+                // Previous solid had no endsolid; drop it if it produced no data
+                sink.commit();
             }
-            
+
             // Extract solid name (everything after "solid")
             std::string solidName;
             std::getline(iss, solidName);
@@ -74,131 +60,108 @@ std::vector<Mesh> parseAsciiStl(std::ifstream& in) {
                 solidName = solidName.substr(1); // Remove leading space
             }
             if (solidName.empty()) {
-                solidName = "mesh_" + std::to_string(meshes.size());
+                solidName = "mesh_" + std::to_string(sink.meshCount());
             }
-            
-            currentMesh.name = solidName;
+
+            currentMesh = &sink.acquire(solidName);
+            welder.begin(*currentMesh);
             vertexCount = 0;
-            inSolid = true;
         }
         else if (keyword == "endsolid") {
-            if (inSolid) {
-                meshes.push_back(std::move(currentMesh));
-                currentMesh.clear();
-                inSolid = false;
+            if (currentMesh) {
+                sink.commit(true);
+                currentMesh = nullptr;
             }
         }
-        else if (keyword == "vertex" && inSolid) {
-            Vec3 v;
-            iss >> v.x >> v.y >> v.z;
-            currentMesh.addVertex(v, currentFace, vertexCount % 3);
+        else if (keyword == "vertex" && currentMesh) {
+            float x = 0, y = 0, z = 0;
+            iss >> x >> y >> z;
+            currentFace[vertexCount % 3] = welder.weld(x, y, z);
             vertexCount++;
         }
-        else if (line.find("endloop") != std::string::npos && inSolid) {
+        else if (line.find("endloop") != std::string::npos && currentMesh) {
             if (vertexCount >= 3) {
-                currentMesh.addFace(currentFace);
+                currentMesh->addTriangle(currentFace[0], currentFace[1], currentFace[2]);
                 vertexCount = 0;
             }
         }
     }
-    
+
     // Handle case where file doesn't end with endsolid
-    if (inSolid && (!currentMesh.vertices.empty() || !currentMesh.faces.empty())) {
-        meshes.push_back(std::move(currentMesh));
+    if (currentMesh) {
+        sink.commit();
     }
-    
-    return meshes;
 }
 
-std::vector<Mesh> parseBinaryStl(std::ifstream& in) {
-    std::vector<Mesh> meshes;
+void parseBinaryStl(std::ifstream& in, MeshSink& sink) {
     char header[80];
     in.read(header, 80);
-    
-    uint32_t numTriangles;
+
+    uint32_t numTriangles = 0;
     in.read(reinterpret_cast<char*>(&numTriangles), 4);
-    
+    if (!in) throw std::runtime_error("Truncated binary STL header");
+
+    // Don't trust the header count further than the file can back it up
+    std::streampos dataStart = in.tellg();
+    in.seekg(0, std::ios::end);
+    uint64_t available = static_cast<uint64_t>(in.tellg() - dataStart) / kBinaryTriangleSize;
+    in.seekg(dataStart);
+    numTriangles = static_cast<uint32_t>(std::min<uint64_t>(numTriangles, available));
+
     // For binary STL, we typically have one mesh, but we'll structure it consistently
-    Mesh mesh;
-    mesh.name = "mesh_0"; // Default name for binary STL
-    
-    for (uint32_t i = 0; i < numTriangles; ++i) {
-        in.ignore(12); // skip normal vector
-        std::array<int, 3> faceIdx;
-        
-        for (int j = 0; j < 3; ++j) {
-            Vec3 v;
-            in.read(reinterpret_cast<char*>(&v), sizeof(Vec3));
-            mesh.addVertex(v, faceIdx, j);
+    Mesh& mesh = sink.acquire("mesh_0"); // Default name for binary STL
+
+    // A closed surface has roughly half as many vertices as triangles
+    size_t expectedVertices = numTriangles / 2 + 3;
+    mesh.reserve(expectedVertices, numTriangles);
+    VertexWelder welder;
+    welder.begin(mesh, expectedVertices);
+
+    std::vector<char> chunk(kBinaryChunkTriangles * kBinaryTriangleSize);
+    uint32_t remaining = numTriangles;
+    while (remaining > 0 && in) {
+        size_t batch = std::min<size_t>(remaining, kBinaryChunkTriangles);
+        in.read(chunk.data(), static_cast<std::streamsize>(batch * kBinaryTriangleSize));
+        size_t got = static_cast<size_t>(in.gcount()) / kBinaryTriangleSize;
+
+        for (size_t t = 0; t < got; ++t) {
+            const char* p = chunk.data() + t * kBinaryTriangleSize + 12; // skip normal vector
+            uint32_t face[3];
+            for (int j = 0; j < 3; ++j, p += 12) {
+                face[j] = welder.weld(readFloat(p), readFloat(p + 4), readFloat(p + 8));
+            }
+            mesh.addTriangle(face[0], face[1], face[2]);
         }
-        
-        mesh.addFace(faceIdx);
-        in.ignore(2); // skip attribute byte count
+
+        remaining -= static_cast<uint32_t>(batch);
+        if (got < batch) break; // truncated file
     }
-    
-    meshes.push_back(std::move(mesh));
-    return meshes;
+
+    sink.commit(true);
 }
 
-void convertStlToJson(const std::string& inputPath, const std::string& outputPath) {
+void readStl(const std::string& inputPath, MeshSink& sink) {
     std::ifstream in(inputPath, std::ios::binary);
     if (!in) throw std::runtime_error("Could not open STL file");
-    
-    std::vector<Mesh> meshes;
-    
+
     if (isAsciiStl(inputPath)) {
         in.close();
         in.open(inputPath); // reopen as text
-        meshes = parseAsciiStl(in);
+        parseAsciiStl(in, sink);
     } else {
-        meshes = parseBinaryStl(in);
+        parseBinaryStl(in, sink);
     }
-    
-    json j;
-    
-    // Check if we have multiple meshes
-    if (meshes.size() == 1) {
-        // Single mesh - maintain backward compatibility with existing format
-        j["vertices"] = json::array();
-        j["faces"] = json::array();
-        
-        for (const auto& v : meshes[0].vertices) {
-            j["vertices"].push_back({v.x, v.y, v.z});
-        }
-        
-        for (const auto& f : meshes[0].faces) {
-            j["faces"].push_back({f[0], f[1], f[2]});
-        }
-        
-        // Optionally include mesh name
-        if (!meshes[0].name.empty() && meshes[0].name != "mesh_0") {
-            j["name"] = meshes[0].name;
-        }
-    } else {
-        // Multiple meshes - use new multi-body format
-        j["meshes"] = json::array();
-        
-        for (const auto& mesh : meshes) {
-            json meshJson;
-            meshJson["name"] = mesh.name;
-            meshJson["vertices"] = json::array();
-            meshJson["faces"] = json::array();
-            
-            for (const auto& v : mesh.vertices) {
-                meshJson["vertices"].push_back({v.x, v.y, v.z});
-            }
-            
-            for (const auto& f : mesh.faces) {
-                meshJson["faces"].push_back({f[0], f[1], f[2]});
-            }
-            
-            j["meshes"].push_back(meshJson);
-        }
-        
-        // Add metadata
-        j["mesh_count"] = meshes.size();
-    }
-    
-    std::ofstream out(outputPath);
-    out << j.dump(2);
-}
\ No newline at end of file
+
+    sink.finish({});
+}
+
+void convertStlToJson(const std::string& inputPath, const std::string& outputPath, MeshArena& meshes) {
+    meshes.reset();
+    mcguire::DocumentSink sink(outputPath, meshes, "mesh_0");
+    readStl(inputPath, sink);
+}
+
+void convertStlToJson(const std::string& inputPath, const std::string& outputPath) {
+    MeshArena meshes;
+    convertStlToJson(inputPath, outputPath, meshes);
+}
@@ -5,7 +5,7 @@ import bcrypt from 'bcrypt';
 import multer from 'multer';
 import fs from 'fs';
 import path from 'path';
-import { execFile } from 'child_process';
+import { execFile, spawn } from 'child_process';
 import { PrismaClient } from '@prisma/client';
 
 const app = express();
@@ -56,9 +56,18 @@ app.post('/api/login', async (req, res) => {
   }
 });
 
+// multer stores uploads without an extension, but the CLI picks its reader from it
+function withOriginalExtension(file) {
+  const ext = path.extname(file.originalname || '').toLowerCase();
+  if (!ext) return file.path;
+  const renamed = `${file.path}${ext}`;
+  fs.renameSync(file.path, renamed);
+  return renamed;
+}
+
 // -- STEP CONVERSION ROUTE --
 app.post('/api/convert-step', upload.single('file'), (req, res) => {
-  const inputPath = req.file.path;
+  const inputPath = withOriginalExtension(req.file);
   const outputPath = `${inputPath}.json`;
 
   // We installed the CLI into /usr/local/bin, so it's on the PATH
@@ -91,6 +100,49 @@ app.post('/api/convert-step', upload.single('file'), (req, res) => {
   });
 });
 
+// -- STREAMING STEP CONVERSION ROUTE --
+// Forwards NDJSON records ({"type":"mesh"} per body, then {"type":"trailer"})
+// to the client as the CLI emits them. A response without a trailer record
+// means the conversion failed part-way.
+app.post('/api/convert-step/stream', upload.single('file'), (req, res) => {
+  const inputPath = withOriginalExtension(req.file);
+  const child = spawn('mcguire_step_cli', ['--stream', inputPath, '-']);
+  let stderr = '';
+  let finished = false;
+
+  child.stdout.on('data', (chunk) => {
+    if (!res.headersSent) {
+      res.status(200).type('application/x-ndjson');
+    }
+    if (!res.write(chunk)) {
+      child.stdout.pause();
+      res.once('drain', () => child.stdout.resume());
+    }
+  });
+  child.stderr.on('data', (chunk) => { stderr += chunk; });
+
+  child.on('close', (code) => {
+    finished = true;
+    fs.unlink(inputPath, () => {});
+
+    if (code !== 0) {
+      console.error('❌ CLI error:', stderr);
+      if (!res.headersSent) return res.status(500).send('STEP conversion failed.');
+    }
+    res.end();
+  });
+
+  child.on('error', (err) => {
+    console.error('❌ CLI spawn error:', err);
+    if (!res.headersSent) res.status(500).send('STEP conversion failed.');
+  });
+
+  // Stop meshing if the client goes away
+  res.on('close', () => {
+    if (!finished) child.kill();
+  });
+});
+
 // -- ERROR LOGGING --
 app.use((err, req, res, next) => {
   console.error("💥 Unhandled error:", err);